@@ -34,11 +34,14 @@ public class AssetExporter : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
+				"AssetRegistry",
 				"CoreUObject",
 				"Engine",
+				"Json",
 				"Slate",
 				"SlateCore",
 				"JsonUtilities",
+				"RHI",
 				//"MeshDescription",
 				//"StaticMeshDescription",
 				// ... add private dependencies that you statically link with here ...	
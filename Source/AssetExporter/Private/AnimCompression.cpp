@@ -0,0 +1,351 @@
+#include "AnimCompression.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	using FCompressedChannel = ns_yoyo::FAnimSequenceResource::FCompressedChannel;
+	using FCompressedTrack = ns_yoyo::FAnimSequenceResource::FCompressedTrack;
+
+	// smallest three components are within +-1/sqrt(2)
+	constexpr float SmallestThreeRange = 0.70710678f;
+	constexpr uint32 SmallestThreeMax = (1 << 15) - 1;
+
+	void EncodeRotation(const FQuat& InRotation, uint16* OutData)
+	{
+		FQuat Rotation = InRotation.GetNormalized();
+		float Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+		uint32 Largest = 0;
+		for (uint32 i = 1; i < 4; ++i)
+		{
+			if (FMath::Abs(Components[i]) > FMath::Abs(Components[Largest]))
+			{
+				Largest = i;
+			}
+		}
+		// q and -q are the same rotation, keep the dropped component positive
+		const float Sign = Components[Largest] < 0.f ? -1.f : 1.f;
+
+		uint64 Bits = (uint64)Largest << 45;
+		uint32 Shift = 30;
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (i == Largest)
+			{
+				continue;
+			}
+			const float Normalized = FMath::Clamp(Components[i] * Sign / SmallestThreeRange * 0.5f + 0.5f, 0.f, 1.f);
+			Bits |= (uint64)FMath::RoundToInt(Normalized * SmallestThreeMax) << Shift;
+			Shift -= 15;
+		}
+		OutData[0] = (uint16)(Bits >> 32);
+		OutData[1] = (uint16)(Bits >> 16);
+		OutData[2] = (uint16)Bits;
+	}
+
+	FQuat DecodeRotation(const uint16* Data)
+	{
+		const uint64 Bits = ((uint64)Data[0] << 32) | ((uint64)Data[1] << 16) | Data[2];
+		const uint32 Largest = (Bits >> 45) & 3;
+		float Components[4];
+		float SumSquares = 0.f;
+		uint32 Shift = 30;
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (i == Largest)
+			{
+				continue;
+			}
+			const uint32 Quantized = (Bits >> Shift) & SmallestThreeMax;
+			Components[i] = ((float)Quantized / SmallestThreeMax * 2.f - 1.f) * SmallestThreeRange;
+			SumSquares += Components[i] * Components[i];
+			Shift -= 15;
+		}
+		Components[Largest] = FMath::Sqrt(FMath::Max(1.f - SumSquares, 0.f));
+		return FQuat(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+	}
+
+	float RotationErrorDegrees(const FQuat& A, const FQuat& B)
+	{
+		// atan2 of the relative rotation, acos of the dot product is too coarse near 1 for tolerances of a few 0.01 degrees
+		const FQuat Delta = A.Inverse() * B;
+		const float SinHalfAngle = FVector(Delta.X, Delta.Y, Delta.Z).Size();
+		return FMath::RadiansToDegrees(2.f * FMath::Atan2(SinHalfAngle, FMath::Abs(Delta.W)));
+	}
+
+	struct FVectorChannelTraits
+	{
+		using FValue = FVector;
+
+		static void Quantize(const TArray<FVector>& Samples, FCompressedChannel& Channel, TArray<uint16>& OutData)
+		{
+			FVector Min = Samples[0];
+			FVector Max = Samples[0];
+			for (const FVector& Sample : Samples)
+			{
+				Min = Min.ComponentMin(Sample);
+				Max = Max.ComponentMax(Sample);
+			}
+			Channel.RangeMin = Min;
+			Channel.RangeExtent = Max - Min;
+			OutData.SetNumUninitialized(Samples.Num() * 3);
+			for (int32 i = 0; i < Samples.Num(); ++i)
+			{
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					const float Extent = Channel.RangeExtent[Axis];
+					const float Normalized = Extent > 0.f ? (Samples[i][Axis] - Min[Axis]) / Extent : 0.f;
+					OutData[i * 3 + Axis] = (uint16)FMath::Clamp(FMath::RoundToInt(Normalized * 65535.f), 0, 65535);
+				}
+			}
+		}
+
+		static FVector Decode(const FCompressedChannel& Channel, const uint16* Data)
+		{
+			return FVector(
+				Channel.RangeMin.X + Channel.RangeExtent.X * (Data[0] / 65535.f),
+				Channel.RangeMin.Y + Channel.RangeExtent.Y * (Data[1] / 65535.f),
+				Channel.RangeMin.Z + Channel.RangeExtent.Z * (Data[2] / 65535.f));
+		}
+
+		static FVector Interpolate(const FVector& A, const FVector& B, float Alpha)
+		{
+			return FMath::Lerp(A, B, Alpha);
+		}
+	};
+
+	struct FRotationChannelTraits
+	{
+		using FValue = FQuat;
+
+		static void Quantize(const TArray<FQuat>& Samples, FCompressedChannel& Channel, TArray<uint16>& OutData)
+		{
+			Channel.RangeMin = FVector::ZeroVector;
+			Channel.RangeExtent = FVector::ZeroVector;
+			OutData.SetNumUninitialized(Samples.Num() * 3);
+			for (int32 i = 0; i < Samples.Num(); ++i)
+			{
+				EncodeRotation(Samples[i], &OutData[i * 3]);
+			}
+		}
+
+		static FQuat Decode(const FCompressedChannel& Channel, const uint16* Data)
+		{
+			return DecodeRotation(Data);
+		}
+
+		static FQuat Interpolate(const FQuat& A, const FQuat& B, float Alpha)
+		{
+			return FQuat::Slerp(A, B, Alpha);
+		}
+	};
+
+	float GetError(const FVector& A, const FVector& B, bool bScale)
+	{
+		return bScale ? (A - B).GetAbsMax() : (A - B).Size();
+	}
+
+	float GetError(const FQuat& A, const FQuat& B, bool)
+	{
+		return RotationErrorDegrees(A, B);
+	}
+
+	// key of Frame and the one after with the blend between them
+	void FindKeys(const FCompressedChannel& Channel, int32 Frame, int32& OutKey0, int32& OutKey1, float& OutAlpha)
+	{
+		const int32 NumKeys = Channel.Data.Num() / 3;
+		check(NumKeys > 0);
+		OutAlpha = 0.f;
+		if (Channel.KeyFrames.Num() == 0)
+		{
+			OutKey0 = OutKey1 = FMath::Clamp(Frame, 0, NumKeys - 1);
+			return;
+		}
+		// first key after Frame
+		int32 Next = Algo::UpperBound(Channel.KeyFrames, (uint16)FMath::Clamp(Frame, 0, (int32)MAX_uint16));
+		if (Next == 0 || Next == NumKeys)
+		{
+			OutKey0 = OutKey1 = FMath::Clamp(Next - 1, 0, NumKeys - 1);
+			return;
+		}
+		OutKey0 = Next - 1;
+		OutKey1 = Next;
+		OutAlpha = (float)(Frame - Channel.KeyFrames[OutKey0]) / (Channel.KeyFrames[OutKey1] - Channel.KeyFrames[OutKey0]);
+	}
+
+	template<typename TTraits>
+	typename TTraits::FValue SampleChannel(const FCompressedChannel& Channel, int32 Frame)
+	{
+		int32 Key0, Key1;
+		float Alpha;
+		FindKeys(Channel, Frame, Key0, Key1, Alpha);
+		const typename TTraits::FValue Value0 = TTraits::Decode(Channel, &Channel.Data[Key0 * 3]);
+		if (Key0 == Key1)
+		{
+			return Value0;
+		}
+		return TTraits::Interpolate(Value0, TTraits::Decode(Channel, &Channel.Data[Key1 * 3]), Alpha);
+	}
+
+	/*
+	* Quantizes every key, then keeps the fewest of them interpolation reproduces the raw keys from
+	* within Tolerance: starting from the first and last key, the worst frame of a span becomes a key
+	* until no span is above Tolerance. Returns the max error over all frames.
+	*/
+	template<typename TTraits>
+	float CompressChannel(const TArray<typename TTraits::FValue>& Samples, int32 NumFrames, float Tolerance, bool bScale,
+		FCompressedChannel& Channel)
+	{
+		using FValue = typename TTraits::FValue;
+		if (Samples.Num() == 0)
+		{
+			return 0.f;
+		}
+
+		// constant, RangeExtent is zero so a vector key decodes to RangeMin exactly
+		bool bConstant = true;
+		for (const FValue& Sample : Samples)
+		{
+			if (GetError(Sample, Samples[0], bScale) > Tolerance)
+			{
+				bConstant = false;
+				break;
+			}
+		}
+		const int32 NumSamples = bConstant ? 1 : Samples.Num();
+
+		TArray<FValue> KeySamples(Samples.GetData(), NumSamples);
+		TArray<uint16> Quantized;
+		TTraits::Quantize(KeySamples, Channel, Quantized);
+
+		TArray<bool> IsKey;
+		IsKey.SetNumZeroed(NumSamples);
+		IsKey[0] = true;
+		IsKey[NumSamples - 1] = true;
+		TArray<TPair<int32, int32>> Spans;
+		if (NumSamples > 2)
+		{
+			Spans.Emplace(0, NumSamples - 1);
+		}
+		while (Spans.Num() > 0)
+		{
+			const TPair<int32, int32> Span = Spans.Pop(false);
+			const FValue First = TTraits::Decode(Channel, &Quantized[Span.Key * 3]);
+			const FValue Last = TTraits::Decode(Channel, &Quantized[Span.Value * 3]);
+			int32 WorstFrame = INDEX_NONE;
+			float WorstError = Tolerance;
+			for (int32 Frame = Span.Key + 1; Frame < Span.Value; ++Frame)
+			{
+				const float Alpha = (float)(Frame - Span.Key) / (Span.Value - Span.Key);
+				const float Error = GetError(TTraits::Interpolate(First, Last, Alpha), Samples[Frame], bScale);
+				if (Error > WorstError)
+				{
+					WorstError = Error;
+					WorstFrame = Frame;
+				}
+			}
+			if (WorstFrame != INDEX_NONE)
+			{
+				IsKey[WorstFrame] = true;
+				if (WorstFrame - Span.Key > 1)
+				{
+					Spans.Emplace(Span.Key, WorstFrame);
+				}
+				if (Span.Value - WorstFrame > 1)
+				{
+					Spans.Emplace(WorstFrame, Span.Value);
+				}
+			}
+		}
+
+		int32 NumKeys = 0;
+		for (bool bKey : IsKey)
+		{
+			NumKeys += bKey ? 1 : 0;
+		}
+		Channel.Data.Reserve(NumKeys * 3);
+		for (int32 Frame = 0; Frame < NumSamples; ++Frame)
+		{
+			if (IsKey[Frame])
+			{
+				Channel.Data.Append(&Quantized[Frame * 3], 3);
+				if (NumKeys < NumSamples)
+				{
+					Channel.KeyFrames.Add((uint16)Frame);
+				}
+			}
+		}
+
+		float MaxError = 0.f;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const FValue& Raw = Samples[FMath::Min(Frame, Samples.Num() - 1)];
+			MaxError = FMath::Max(MaxError, GetError(SampleChannel<TTraits>(Channel, Frame), Raw, bScale));
+		}
+		return MaxError;
+	}
+}
+
+bool ns_yoyo::CompressAnimSequence(FAnimSequenceResource& Resource, const FAnimCompressionSettings& Settings,
+	TArray<FAnimTrackError>& OutErrors)
+{
+	if (Resource.NumFrames > MAX_uint16 + 1)
+	{
+		return false;
+	}
+
+	const TArray<FAnimSequenceResource::FTrack>& RawTracks = Resource.RawAnimationData;
+	TArray<FCompressedTrack> CompressedTracks;
+	CompressedTracks.SetNum(RawTracks.Num());
+	OutErrors.SetNum(RawTracks.Num());
+	ParallelFor(RawTracks.Num(), [&](int32 TrackIndex)
+	{
+		const FAnimSequenceResource::FTrack& Raw = RawTracks[TrackIndex];
+		FCompressedTrack& Compressed = CompressedTracks[TrackIndex];
+		FAnimTrackError& Error = OutErrors[TrackIndex];
+		Error.Position = CompressChannel<FVectorChannelTraits>(Raw.PosKeys, Resource.NumFrames, Settings.PositionTolerance, false, Compressed.PosKeys);
+		Error.Rotation = CompressChannel<FRotationChannelTraits>(Raw.RotKeys, Resource.NumFrames, Settings.RotationTolerance, false, Compressed.RotKeys);
+		Error.Scale = CompressChannel<FVectorChannelTraits>(Raw.ScaleKeys, Resource.NumFrames, Settings.ScaleTolerance, true, Compressed.ScaleKeys);
+	});
+
+	Resource.CompressedAnimationData = MoveTemp(CompressedTracks);
+	Resource.RawAnimationData.Empty();
+	return true;
+}
+
+uint64 ns_yoyo::GetAnimationDataSize(const FAnimSequenceResource& Resource)
+{
+	uint64 Size = 0;
+	for (const FAnimSequenceResource::FTrack& Track : Resource.RawAnimationData)
+	{
+		Size += Track.PosKeys.Num() * sizeof(FVector) + Track.RotKeys.Num() * sizeof(FQuat) + Track.ScaleKeys.Num() * sizeof(FVector);
+	}
+	for (const FCompressedTrack& Track : Resource.CompressedAnimationData)
+	{
+		for (const FCompressedChannel* Channel : { &Track.PosKeys, &Track.RotKeys, &Track.ScaleKeys })
+		{
+			Size += (Channel->KeyFrames.Num() + Channel->Data.Num()) * sizeof(uint16) + 2 * sizeof(FVector);
+		}
+	}
+	return Size;
+}
+
+FVector ns_yoyo::DecodeVectorKey(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Key)
+{
+	return FVectorChannelTraits::Decode(Channel, &Channel.Data[Key * 3]);
+}
+
+FQuat ns_yoyo::DecodeRotationKey(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Key)
+{
+	return DecodeRotation(&Channel.Data[Key * 3]);
+}
+
+FVector ns_yoyo::SampleCompressedVector(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Frame)
+{
+	return SampleChannel<FVectorChannelTraits>(Channel, Frame);
+}
+
+FQuat ns_yoyo::SampleCompressedRotation(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Frame)
+{
+	return SampleChannel<FRotationChannelTraits>(Channel, Frame);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	struct FAnimCompressionSettings
+	{
+		// max error allowed by key reduction, in cm, degrees and scale units
+		float PositionTolerance = 0.01f;
+		float RotationTolerance = 0.05f;
+		float ScaleTolerance = 0.001f;
+	};
+
+	// max error of a compressed track against the raw keys, over every frame
+	struct FAnimTrackError
+	{
+		float Position = 0.f;
+		// degrees
+		float Rotation = 0.f;
+		float Scale = 0.f;
+	};
+
+	/*
+	* Replaces RawAnimationData with CompressedAnimationData:
+	* - channels within tolerance of their first key collapse to that single key
+	* - positions and scales are quantized to 16 bit in the range of their channel
+	* - rotations are quantized to 48 bit, the three smallest components at 15 bit each
+	* - keys that interpolation of their neighbours reproduces within tolerance are removed
+	* Key removal measures the error of the quantized keys, so OutErrors is what a runtime
+	* decoding like SampleCompressedVector/Rotation sees. Returns false and leaves the resource raw
+	* when it can't be compressed (more frames than uint16 key frames can address).
+	*/
+	bool CompressAnimSequence(FAnimSequenceResource& Resource, const FAnimCompressionSettings& Settings,
+		TArray<FAnimTrackError>& OutErrors);
+
+	// bytes of the key data, raw or compressed
+	uint64 GetAnimationDataSize(const FAnimSequenceResource& Resource);
+
+	// reference decoders
+	FVector DecodeVectorKey(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Key);
+	FQuat DecodeRotationKey(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Key);
+	FVector SampleCompressedVector(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Frame);
+	FQuat SampleCompressedRotation(const FAnimSequenceResource::FCompressedChannel& Channel, int32 Frame);
+}
@@ -0,0 +1,134 @@
+#include "AnimSampling.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// Keys sampled at Time in source frames, a channel without keys is Default
+	template<typename T, typename TInterpolate>
+	T SampleKeys(const TArray<T>& Keys, float Time, const T& Default, TInterpolate Interpolate)
+	{
+		if (Keys.Num() == 0)
+		{
+			return Default;
+		}
+		const int32 Key = FMath::Clamp(FMath::FloorToInt(Time), 0, Keys.Num() - 1);
+		const int32 NextKey = FMath::Min(Key + 1, Keys.Num() - 1);
+		return Key == NextKey ? Keys[Key] : Interpolate(Keys[Key], Keys[NextKey], Time - Key);
+	}
+
+	FVector LerpVector(const FVector& A, const FVector& B, float Alpha)
+	{
+		return FMath::Lerp(A, B, Alpha);
+	}
+
+	FQuat SlerpRotation(const FQuat& A, const FQuat& B, float Alpha)
+	{
+		return FQuat::Slerp(A, B, Alpha);
+	}
+
+	template<typename T>
+	const T& GetFrameKey(const TArray<T>& Keys, int32 Frame, const T& Default)
+	{
+		return Keys.Num() == 0 ? Default : Keys[FMath::Min(Frame, Keys.Num() - 1)];
+	}
+}
+
+void ns_yoyo::ResampleAnimSequence(FAnimSequenceResource& AnimSeq, float SequenceLength, float FrameRate)
+{
+	check(FrameRate > 0.f);
+	const int32 NumSourceFrames = AnimSeq.NumFrames;
+	const int32 NumFrames = SequenceLength > 0.f && NumSourceFrames > 1
+		? FMath::CeilToInt(SequenceLength * FrameRate - KINDA_SMALL_NUMBER) + 1 : 1;
+	// source frames per resampled frame
+	const float Step = NumSourceFrames > 1 ? (NumSourceFrames - 1) / (SequenceLength * FrameRate) : 0.f;
+	const float LastSourceFrame = FMath::Max(NumSourceFrames - 1, 0);
+
+	for (FAnimSequenceResource::FTrack& Track : AnimSeq.RawAnimationData)
+	{
+		FAnimSequenceResource::FTrack Resampled;
+		auto ResampleChannel = [NumFrames, Step, LastSourceFrame](const auto& Keys, auto& OutKeys, const auto& Default, auto Interpolate)
+		{
+			if (Keys.Num() <= 1)
+			{
+				OutKeys = Keys;
+				return;
+			}
+			OutKeys.SetNumUninitialized(NumFrames);
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				OutKeys[Frame] = SampleKeys(Keys, FMath::Min(Frame * Step, LastSourceFrame), Default, Interpolate);
+			}
+		};
+		ResampleChannel(Track.PosKeys, Resampled.PosKeys, FVector::ZeroVector, LerpVector);
+		ResampleChannel(Track.RotKeys, Resampled.RotKeys, FQuat::Identity, SlerpRotation);
+		ResampleChannel(Track.ScaleKeys, Resampled.ScaleKeys, FVector::OneVector, LerpVector);
+		Track = MoveTemp(Resampled);
+	}
+	AnimSeq.NumFrames = NumFrames;
+	AnimSeq.FrameRate = FrameRate;
+}
+
+void ns_yoyo::BakeBoneMatrices(FAnimSequenceResource& AnimSeq, const FSkeleton& Skeleton, FAnimSequenceResource::EBakedSpace Space)
+{
+	check(AnimSeq.TrackToBoneIndices.Num() == AnimSeq.RawAnimationData.Num());
+	const int32 NumBones = Skeleton.BoneInfos.Num();
+	const int32 NumFrames = FMath::Max(AnimSeq.NumFrames, 1);
+
+	TArray<int32> BoneTracks;
+	BoneTracks.Init(INDEX_NONE, NumBones);
+	for (int32 TrackIndex = 0; TrackIndex < AnimSeq.TrackToBoneIndices.Num(); ++TrackIndex)
+	{
+		const int32 BoneIndex = AnimSeq.TrackToBoneIndices[TrackIndex];
+		if (BoneTracks.IsValidIndex(BoneIndex))
+		{
+			BoneTracks[BoneIndex] = TrackIndex;
+		}
+	}
+
+	// parents come before their children in a reference skeleton
+	TArray<FMatrix> BindMatrices;
+	BindMatrices.SetNumUninitialized(NumBones);
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+	{
+		const KTransform& Pose = Skeleton.BonePoses[BoneIndex];
+		const int32 ParentIndex = Skeleton.BoneInfos[BoneIndex].ParentIndex;
+		check(ParentIndex < BoneIndex);
+		const FMatrix LocalMatrix = FTransform(Pose.Rot, Pose.Trans, Pose.Scale).ToMatrixWithScale();
+		BindMatrices[BoneIndex] = ParentIndex == INDEX_NONE ? LocalMatrix : LocalMatrix * BindMatrices[ParentIndex];
+	}
+	TArray<FMatrix> InverseBindMatrices;
+	if (Space == FAnimSequenceResource::EBakedSpace::Skinning)
+	{
+		InverseBindMatrices.SetNumUninitialized(NumBones);
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+		{
+			InverseBindMatrices[BoneIndex] = BindMatrices[BoneIndex].Inverse();
+		}
+	}
+
+	AnimSeq.BakedSpace = Space;
+	AnimSeq.NumBakedBones = NumBones;
+	AnimSeq.BakedMatrices.SetNumUninitialized(NumFrames * NumBones);
+	ParallelFor(NumFrames, [&AnimSeq, &Skeleton, &BoneTracks, &InverseBindMatrices, NumBones](int32 Frame)
+	{
+		TArray<FMatrix> ModelMatrices;
+		ModelMatrices.SetNumUninitialized(NumBones);
+		FMatrix3x4* OutMatrices = AnimSeq.BakedMatrices.GetData() + Frame * NumBones;
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+		{
+			const KTransform& Pose = Skeleton.BonePoses[BoneIndex];
+			FTransform Local(Pose.Rot, Pose.Trans, Pose.Scale);
+			if (BoneTracks[BoneIndex] != INDEX_NONE)
+			{
+				const FAnimSequenceResource::FTrack& Track = AnimSeq.RawAnimationData[BoneTracks[BoneIndex]];
+				Local = FTransform(GetFrameKey(Track.RotKeys, Frame, Pose.Rot).GetNormalized(),
+					GetFrameKey(Track.PosKeys, Frame, Pose.Trans), GetFrameKey(Track.ScaleKeys, Frame, Pose.Scale));
+			}
+			const FMatrix LocalMatrix = Local.ToMatrixWithScale();
+			const int32 ParentIndex = Skeleton.BoneInfos[BoneIndex].ParentIndex;
+			ModelMatrices[BoneIndex] = ParentIndex == INDEX_NONE ? LocalMatrix : LocalMatrix * ModelMatrices[ParentIndex];
+			OutMatrices[BoneIndex] = FMatrix3x4::FromMatrix(InverseBindMatrices.Num() > 0
+				? InverseBindMatrices[BoneIndex] * ModelMatrices[BoneIndex] : ModelMatrices[BoneIndex]);
+		}
+	});
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Resamples the raw tracks of AnimSeq, NumFrames keys spread over SequenceLength seconds, at
+	* FrameRate. Positions and scales are interpolated linearly, rotations with FQuat::Slerp, single
+	* key channels stay single keys. The last frame is the end of the sequence, less than a frame
+	* after the one before it when the length isn't a whole number of frames.
+	*/
+	void ResampleAnimSequence(FAnimSequenceResource& AnimSeq, float SequenceLength, float FrameRate);
+
+	/*
+	* Fills BakedMatrices with the Space matrices of every bone of Skeleton at every frame of the raw
+	* tracks, bones without a track keep their bind pose. Frames are baked side by side with ParallelFor.
+	* TrackToBoneIndices must be filled.
+	*/
+	void BakeBoneMatrices(FAnimSequenceResource& AnimSeq, const FSkeleton& Skeleton, FAnimSequenceResource::EBakedSpace Space);
+}
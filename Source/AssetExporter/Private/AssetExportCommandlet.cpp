@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AssetExportCommandlet.h"
+#include "AssetExporterBPLibrary.h"
+#include "AssetRegistryModule.h"
+#include "Modules/ModuleManager.h"
+#include "UObject/UObjectGlobals.h"
+
+#include "ExportManifest.h"
+#include "ExportReport.h"
+#include "ExportSession.h"
+
+UAssetExportCommandlet::UAssetExportCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UAssetExportCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString OutPath = ParamVals.FindRef(TEXT("out"));
+	if (OutPath.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=AssetExport -out=<Dir> [-path=/Game/A,/Game/B] [-classes=StaticMesh,...] [-shard=i/N] [-batchsize=64]"));
+		return 1;
+	}
+
+	TArray<FString> ContentPaths;
+	ParamVals.FindRef(TEXT("path")).ParseIntoArray(ContentPaths, TEXT(","));
+	if (ContentPaths.Num() == 0)
+	{
+		ContentPaths.Add(TEXT("/Game"));
+	}
+
+	TArray<FString> ClassNames;
+	ParamVals.FindRef(TEXT("classes")).ParseIntoArray(ClassNames, TEXT(","));
+	if (ClassNames.Num() == 0)
+	{
+		ClassNames = { TEXT("StaticMesh"), TEXT("SkeletalMesh"), TEXT("AnimSequence"), TEXT("Skeleton") };
+	}
+
+	int32 ShardIndex = 0;
+	int32 NumShards = 1;
+	const FString Shard = ParamVals.FindRef(TEXT("shard"));
+	if (!Shard.IsEmpty())
+	{
+		FString Index, Count;
+		if (!Shard.Split(TEXT("/"), &Index, &Count) || FCString::Atoi(*Count) <= 0
+			|| FCString::Atoi(*Index) < 0 || FCString::Atoi(*Index) >= FCString::Atoi(*Count))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Invalid -shard=%s, expected i/N with 0 <= i < N"), *Shard);
+			return 1;
+		}
+		ShardIndex = FCString::Atoi(*Index);
+		NumShards = FCString::Atoi(*Count);
+	}
+
+	const FString BatchSizeParam = ParamVals.FindRef(TEXT("batchsize"));
+	const int32 BatchSize = BatchSizeParam.IsEmpty() ? 64 : FMath::Max(FCString::Atoi(*BatchSizeParam), 1);
+
+	// enumerate
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	for (const FString& ContentPath : ContentPaths)
+	{
+		Filter.PackagePaths.Add(FName(*ContentPath));
+	}
+	for (const FString& ClassName : ClassNames)
+	{
+		Filter.ClassNames.Add(FName(*ClassName));
+	}
+	Filter.bRecursivePaths = true;
+	Filter.bRecursiveClasses = true;
+
+	TArray<FAssetData> AllAssets;
+	AssetRegistry.GetAssets(Filter, AllAssets);
+
+	// shards are picked by package name hash, stable across machines and as content is added
+	TArray<FAssetData> Assets;
+	for (FAssetData& AssetData : AllAssets)
+	{
+		if (FCrc::StrCrc32(*AssetData.PackageName.ToString()) % NumShards == (uint32)ShardIndex)
+		{
+			Assets.Add(MoveTemp(AssetData));
+		}
+	}
+	Assets.Sort([](const FAssetData& A, const FAssetData& B) { return A.ObjectPath.LexicalLess(B.ObjectPath); });
+	UE_LOG(LogTemp, Display, TEXT("Exporting %d of %d assets (shard %d/%d) to %s"),
+		Assets.Num(), AllAssets.Num(), ShardIndex, NumShards, *OutPath);
+
+	// every shard keeps its own manifest so they never write the same file
+	const FString ManifestName = NumShards > 1
+		? FString::Printf(TEXT("AssetExporter.%dof%d"), ShardIndex, NumShards)
+		: FString(TEXT("AssetExporter"));
+	// one session over every batch, skeletons shared by the batches are written once
+	ns_yoyo::FExportSession Session(OutPath, UAssetExporterBPLibrary::GetExportSettingsHash(), ManifestName,
+		UAssetExporterBPLibrary::IsExportReportEnabled());
+	ns_yoyo::FExportManifest& Manifest = Session.GetManifest();
+
+	// load, export and drop a batch at a time to keep memory flat
+	int32 NumFailed = 0;
+	TArray<UObject*> Batch;
+	for (int32 BatchStart = 0; BatchStart < Assets.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchEnd = FMath::Min(BatchStart + BatchSize, Assets.Num());
+		for (int32 i = BatchStart; i < BatchEnd; ++i)
+		{
+			UObject* Asset = Assets[i].GetAsset();
+			if (Asset)
+			{
+				Batch.Add(Asset);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to load %s"), *Assets[i].ObjectPath.ToString());
+				++NumFailed;
+			}
+		}
+
+		UAssetExporterBPLibrary::ExportAssets(Batch, Session);
+		Batch.Reset();
+
+		// saved per batch so an interrupted run resumes where it stopped
+		Manifest.Save();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		UE_LOG(LogTemp, Display, TEXT("Exported %d/%d assets"), BatchEnd, Assets.Num());
+	}
+
+	// shards leave the blobs to a run over the whole root, another shard may still be writing one
+	int32 NumRemoved = Manifest.RemoveStaleEntries(NumShards == 1);
+	UE_LOG(LogTemp, Display, TEXT("Removed %d exported files of deleted assets"), NumRemoved);
+	if (Session.GetReport())
+	{
+		UAssetExporterBPLibrary::SaveExportReport(*Session.GetReport(), OutPath / ManifestName + TEXT(".report"));
+	}
+	Session.LogStats();
+	if (!Manifest.Save())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to save the export manifest in %s"), *OutPath);
+		return 1;
+	}
+	return NumFailed > 0 ? 1 : 0;
+}
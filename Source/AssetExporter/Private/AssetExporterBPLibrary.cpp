@@ -3,21 +3,35 @@
 #include "AssetExporterBPLibrary.h"
 #include "AssetExporter.h"
 #include "Animation/AnimTypes.h"
+#include "Async/ParallelFor.h"
 #include "Camera/CameraActor.h"
 #include "Camera/CameraComponent.h"
 #include "Components/DirectionalLightComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Components/PrimitiveComponent.h"
 #include "Engine/Classes/Animation/SkeletalMeshActor.h"
 #include "Engine/Classes/Animation/AnimSequence.h"
 #include "Engine/Classes/Animation/Skeleton.h"
 #include "Engine/Classes/GameFramework/Character.h"
 #include "Engine/DirectionalLight.h"
+#include "Engine/LevelStreaming.h"
 #include "Engine/SkeletalMesh.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/StaticMeshActor.h"
+#include "Engine/Texture2D.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/ThreadSafeCounter.h"
 //#include "JsonObjectConverter.h"
 #include "Misc/FileHelper.h"
 #include "Misc/PackageName.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "Materials/MaterialInstance.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/Paths.h"
+#include "RHI.h"
 #include "Rendering/SkeletalMeshLODRenderData.h"
 #include "Rendering/SkeletalMeshRenderData.h"
 #include "Rendering/SkinWeightVertexBuffer.h"
@@ -26,55 +40,1524 @@
 #include "SingleAnimationPlayData.h"
 #include "ReferenceSkeleton.h"
 
+#include "AnimCompression.h"
+#include "AnimSampling.h"
+#include "CompressedResource.h"
+#include "ExportJobGraph.h"
+#include "ExportManifest.h"
+#include "ExportReport.h"
+#include "ExportSession.h"
 #include "ExportTypes.h"
+#include "MappedResource.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "SceneBVH.h"
+#include "SceneCells.h"
+#include "SceneColumns.h"
+#include "TextureTranscode.h"
+#include "VertexAnimation.h"
+
+// how resources are laid out on disk, see GetSerializeOptions
+struct FSerializeOptions
+{
+	bool bMapped = false;
+	ns_yoyo::ECompressionCodec Codec = ns_yoyo::ECompressionCodec::None;
+	uint32 ChunkSize = 0;
+};
 
 template<typename T>
-bool SerializeToFile(T& Obj, const FString& Path)
+bool SerializeToFile(T& Obj, const FString& Path, const FSerializeOptions& Options = FSerializeOptions())
 {
+	// stream straight into a temp file through the buffered file writer, no byte copy
+	// of the whole resource is kept, and rename once complete so readers never see
+	// a half written file. the temp name carries the process id, shards running side by side
+	// may export the same referenced asset
 	FString SavePath = Path + Obj.Path;
-	TArray<uint8> ByteData;
-	FMemoryWriter BytesWriter(ByteData);
-	BytesWriter << Obj;
-	return FFileHelper::SaveArrayToFile(ByteData, *SavePath);
+	FString TempPath = SavePath + FString::Printf(TEXT(".%u.tmp"), FPlatformProcess::GetCurrentProcessId());
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*TempPath));
+	if (!FileWriter)
+	{
+		return false;
+	}
+	// compression wraps the whole stream, mapped or not
+	TOptional<ns_yoyo::FChunkedCompressionWriter> CompressionWriter;
+	if (Options.Codec != ns_yoyo::ECompressionCodec::None)
+	{
+		CompressionWriter.Emplace(*FileWriter, Obj.Type, Options.Codec, Options.ChunkSize);
+	}
+	FArchive& Ar = CompressionWriter ? static_cast<FArchive&>(*CompressionWriter) : *FileWriter;
+	if (Options.bMapped)
+	{
+		ns_yoyo::WriteMappedResource(Ar, Obj);
+	}
+	else
+	{
+		Ar << Obj;
+	}
+	bool bOk = !CompressionWriter || CompressionWriter->Close();
+	CompressionWriter.Reset();
+	bOk = FileWriter->Close() && bOk;
+	FileWriter.Reset();
+	if (bOk)
+	{
+		bOk = IFileManager::Get().Move(*SavePath, *TempPath, true, true);
+	}
+	if (!bOk)
+	{
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+	}
+	return bOk;
+}
+#if 1
+template<ns_yoyo::EResourceType ResourceType>
+FString GetAssetPath(UObject* Asset)
+{
+	auto package_path = Asset->GetPackage()->GetPathName();
+	package_path.ReplaceInline(TEXT("/Game"), TEXT(""));
+	switch (ResourceType)
+	{
+	case ns_yoyo::EResourceType::Level:
+		package_path += TEXT(".scene");
+		break;
+	case ns_yoyo::EResourceType::StaticMesh:
+		package_path += TEXT(".mesh");
+		break;
+	case ns_yoyo::EResourceType::SkeletalMesh:
+		package_path += TEXT(".skelmesh");
+		break;
+	case ns_yoyo::EResourceType::AnimSequence:
+		package_path += TEXT(".anim");
+		break;
+	case ns_yoyo::EResourceType::Skeleton:
+		package_path += TEXT(".skel");
+		break;
+	case ns_yoyo::EResourceType::Texture:
+		package_path += TEXT(".tex");
+		break;
+	case ns_yoyo::EResourceType::Max:
+	default:
+		check(false);
+		break;
+	}
+	return package_path;
+}
+#else
+FString GetAssetPath(UObject* Asset)
+{
+	auto package_path = Asset->GetPackage()->GetPathName();
+	package_path.ReplaceInline(TEXT("/Game"), TEXT(""));
+	return package_path;
+}
+#endif
+
+static TAutoConsoleVariable<int32> CVarExportNumThreads(
+	TEXT("AssetExporter.NumThreads"),
+	0,
+	TEXT("Number of threads converting resources, one more thread writes them while the next ones convert.\n")
+	TEXT(" 0: one per task graph worker plus the game thread (default)\n")
+	TEXT(" 1: export serially on the game thread"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportMemoryBudgetMB(
+	TEXT("AssetExporter.MemoryBudgetMB"),
+	4096,
+	TEXT("Estimated megabytes of converted resources in flight at once, an asset waits until it fits.\n")
+	TEXT("A bigger asset is exported alone. 0: no limit"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportIncremental(
+	TEXT("AssetExporter.Incremental"),
+	1,
+	TEXT("Skip assets whose package and exported file are unchanged since the last export.\n")
+	TEXT("The record is kept in AssetExporter.manifest under the output root."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<FString> CVarExportVertexLayout(
+	TEXT("AssetExporter.VertexLayout"),
+	TEXT("Position=Float3 Normal=Float3 TexCoord0=Float2"),
+	TEXT("Vertex attributes written to .mesh/.skelmesh files, in order, as Attribute=Encoding pairs.\n")
+	TEXT(" Position: Float3, Quantized16\n")
+	TEXT(" Normal: Float3, Oct16\n")
+	TEXT(" Tangent: Float4, Oct16\n")
+	TEXT(" TexCoord0..7: Float2, Half2\n")
+	TEXT(" Color: Float4, RGBA8"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<FString> CVarExportLODs(
+	TEXT("AssetExporter.LODs"),
+	TEXT("All"),
+	TEXT("LODs of static and skeletal meshes to export, All or a comma separated list of LOD indices, e.g. 0,2.\n")
+	TEXT("Indices a mesh doesn't have are skipped, LOD 0 is exported when none is left."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportOptimizeMeshes(
+	TEXT("AssetExporter.OptimizeMeshes"),
+	0,
+	TEXT("Reorder triangles for the post transform vertex cache and vertices for fetch locality\n")
+	TEXT("in every section of exported meshes. ACMR/ATVR before and after are logged."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportPackedSkinWeights(
+	TEXT("AssetExporter.PackedSkinWeights"),
+	0,
+	TEXT("Store the bone indices of skin weights in a byte when no section has more than 256 bones,\n")
+	TEXT("with weights renormalized to sum to 255. 16 bit bone indices otherwise."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportBuildMeshlets(
+	TEXT("AssetExporter.BuildMeshlets"),
+	0,
+	TEXT("Split every section of exported meshes into meshlets of at most 64 vertices and 124 triangles,\n")
+	TEXT("with bounding spheres and normal cones for cluster culling."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportMappedFormat(
+	TEXT("AssetExporter.MappedFormat"),
+	0,
+	TEXT("Write resources in the memory mappable layout: fixed header, section table and\n")
+	TEXT("16 byte aligned vertex/index/skin weight/animation key blobs, see MappedResource.h."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<FString> CVarExportCompression(
+	TEXT("AssetExporter.Compression"),
+	TEXT("None"),
+	TEXT("Compress resource files in independent chunks, see CompressedResource.h.\n")
+	TEXT(" None, Zlib, LZ4, Oodle (needs the Oodle plugin)"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportCompressionChunkSize(
+	TEXT("AssetExporter.CompressionChunkSize"),
+	256 * 1024,
+	TEXT("Uncompressed size in bytes of the chunks AssetExporter.Compression compresses independently."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportSharedBlobs(
+	TEXT("AssetExporter.SharedBlobs"),
+	0,
+	TEXT("1: write vertex, index and skin weight data into content addressed /Blobs/<md5>.bin files shared by\n")
+	TEXT("every asset with identical data, resources keep only the blob path. Blobs are never compressed.\n")
+	TEXT("0: keep the data inside every resource (default)"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportTextures(
+	TEXT("AssetExporter.Textures"),
+	1,
+	TEXT("Export the UTexture2Ds the materials of exported meshes reference, once per session.\n")
+	TEXT("The material tables of the meshes list them either way."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportCompressAnimations(
+	TEXT("AssetExporter.CompressAnimations"),
+	0,
+	TEXT("Reduce and quantize the keys of exported animations, see AnimCompression.h.\n")
+	TEXT("The max error of every bone is logged with LogTemp Verbose."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarExportAnimPositionTolerance(
+	TEXT("AssetExporter.AnimPositionTolerance"),
+	0.01f,
+	TEXT("Max translation error in cm AssetExporter.CompressAnimations may introduce."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarExportAnimRotationTolerance(
+	TEXT("AssetExporter.AnimRotationTolerance"),
+	0.05f,
+	TEXT("Max rotation error in degrees AssetExporter.CompressAnimations may introduce."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarExportAnimScaleTolerance(
+	TEXT("AssetExporter.AnimScaleTolerance"),
+	0.001f,
+	TEXT("Max scale error AssetExporter.CompressAnimations may introduce."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarExportAnimSampleRate(
+	TEXT("AssetExporter.AnimSampleRate"),
+	0.f,
+	TEXT("Resample exported animations at this many frames per second.\n")
+	TEXT(" 0: keep the keys of the source (default)"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportAnimBakeMatrices(
+	TEXT("AssetExporter.AnimBakeMatrices"),
+	0,
+	TEXT("Bake a 3x4 matrix per bone and frame into exported animations, see FAnimSequenceResource::EBakedSpace:\n")
+	TEXT(" 0: keys only (default)\n")
+	TEXT(" 1: bone to model space\n")
+	TEXT(" 2: skinning matrices, relative to the bind pose of the skeleton"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportVertexAnimationLOD(
+	TEXT("AssetExporter.VertexAnimationLOD"),
+	-1,
+	TEXT("Exported LOD of the mesh ExportVertexAnimations skins, 0 being the most detailed one.\n")
+	TEXT(" -1: the least detailed exported LOD (default)"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarExportSceneCellSize(
+	TEXT("AssetExporter.SceneCellSize"),
+	0.f,
+	TEXT("Split exported scenes into square grid cells of this size in cm on the XY plane, each written\n")
+	TEXT("to <Map>/Cell_<X>_<Y>.scene, with <Map>.scene holding the cell bounds and the meshes they need.\n")
+	TEXT(" 0: write every instance into <Map>.scene (default)"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportSceneEncoding(
+	TEXT("AssetExporter.SceneEncoding"),
+	0,
+	TEXT("How scenes store their instances, see ESceneEncoding:\n")
+	TEXT(" 0: static mesh instance groups and a record per skeletal mesh (default)\n")
+	TEXT(" 1: columns of rotations, translations and scales with a resource index per instance\n")
+	TEXT(" 2: columns of 3x4 world matrices with a resource index per instance"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportReport(
+	TEXT("AssetExporter.Report"),
+	1,
+	TEXT("Write AssetExporter.report.json/.csv into the output root after ExportMap and commandlet runs:\n")
+	TEXT("bytes written, vertex/triangle counts, seconds per stage and peak memory of every asset."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarExportReportSlowest(
+	TEXT("AssetExporter.ReportSlowest"),
+	20,
+	TEXT("Number of slowest assets listed in the export report."),
+	ECVF_Default);
+
+static ns_yoyo::FVertexLayout GetVertexLayout()
+{
+	ns_yoyo::FVertexLayout Layout;
+	const FString Desc = CVarExportVertexLayout.GetValueOnGameThread();
+	if (!ns_yoyo::FVertexLayout::Parse(Desc, Layout))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Invalid AssetExporter.VertexLayout \"%s\", using the default layout"), *Desc);
+		Layout = ns_yoyo::FVertexLayout::Default();
+	}
+	return Layout;
+}
+
+// indices of the LODs to export out of NumLODs, in order
+static TArray<int32> GetExportedLODs(int32 NumLODs)
+{
+	TArray<int32> LODs;
+	const FString Desc = CVarExportLODs.GetValueOnGameThread().TrimStartAndEnd();
+	if (Desc.IsEmpty() || Desc == TEXT("All"))
+	{
+		for (int32 LODIndex = 0; LODIndex < NumLODs; ++LODIndex)
+		{
+			LODs.Add(LODIndex);
+		}
+		return LODs;
+	}
+	TArray<FString> Tokens;
+	Desc.ParseIntoArray(Tokens, TEXT(","));
+	for (const FString& Token : Tokens)
+	{
+		const int32 LODIndex = FCString::Atoi(*Token.TrimStartAndEnd());
+		if (LODIndex >= 0 && LODIndex < NumLODs)
+		{
+			LODs.AddUnique(LODIndex);
+		}
+	}
+	if (LODs.Num() == 0)
+	{
+		LODs.Add(0);
+	}
+	LODs.Sort();
+	return LODs;
+}
+
+// every setting that changes the exported bytes, the manifest re-exports assets when it changes
+uint32 UAssetExporterBPLibrary::GetExportSettingsHash()
+{
+	const FString Settings = CVarExportVertexLayout.GetValueOnGameThread()
+		+ FString::Printf(TEXT("|LODs=%s"), *CVarExportLODs.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|Optimize=%d"), CVarExportOptimizeMeshes.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|Meshlets=%d"), CVarExportBuildMeshlets.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|PackedSkinWeights=%d"), CVarExportPackedSkinWeights.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|Mapped=%d"), CVarExportMappedFormat.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|Compression=%s/%d"), *CVarExportCompression.GetValueOnGameThread(),
+			CVarExportCompressionChunkSize.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|SharedBlobs=%d"), CVarExportSharedBlobs.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|Anim=%d/%g/%g/%g"), CVarExportCompressAnimations.GetValueOnGameThread(),
+			CVarExportAnimPositionTolerance.GetValueOnGameThread(), CVarExportAnimRotationTolerance.GetValueOnGameThread(),
+			CVarExportAnimScaleTolerance.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|AnimSampling=%g/%d"), CVarExportAnimSampleRate.GetValueOnGameThread(),
+			CVarExportAnimBakeMatrices.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|VertexAnimationLOD=%d"), CVarExportVertexAnimationLOD.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|CellSize=%g"), CVarExportSceneCellSize.GetValueOnGameThread())
+		+ FString::Printf(TEXT("|SceneEncoding=%d"), CVarExportSceneEncoding.GetValueOnGameThread());
+	return FCrc::StrCrc32(*Settings);
+}
+
+static FSerializeOptions GetSerializeOptions()
+{
+	FSerializeOptions Options;
+	Options.bMapped = CVarExportMappedFormat.GetValueOnAnyThread() != 0;
+	const FString CodecName = CVarExportCompression.GetValueOnAnyThread();
+	if (!ns_yoyo::ParseCompressionCodec(CodecName, Options.Codec))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Invalid AssetExporter.Compression \"%s\", writing uncompressed"), *CodecName);
+		Options.Codec = ns_yoyo::ECompressionCodec::None;
+	}
+	else if (!ns_yoyo::IsCompressionCodecAvailable(Options.Codec))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Compression codec %s isn't available, writing uncompressed"), *CodecName);
+		Options.Codec = ns_yoyo::ECompressionCodec::None;
+	}
+	Options.ChunkSize = FMath::Max(CVarExportCompressionChunkSize.GetValueOnAnyThread(), 4096);
+	return Options;
+}
+
+/*
+* Exporting is split in two stages.
+* Gather runs on the game thread and touches every UObject the export needs:
+* asset paths, render data and raw animation data.
+* Build reads only what was gathered, so it may run on any thread.
+*/
+struct FAssetSource
+{
+	// resource path relative to the output root
+	FString Path;
+	// source package, used by the export manifest
+	FString PackageName;
+	FString PackageFilename;
+	// timings of this asset, when the export keeps a report
+	ns_yoyo::FAssetExportRecord* Record = nullptr;
+};
+
+static void AddReportRecord(ns_yoyo::FExportReport* Report, ns_yoyo::EResourceType Type, FAssetSource& Source)
+{
+	Source.Record = Report ? Report->AddAsset(Source.Path, Type) : nullptr;
+}
+
+static void GatherPackage(UObject* Asset, FAssetSource& Source)
+{
+	Source.PackageName = Asset->GetPackage()->GetPathName();
+	FPackageName::DoesPackageExist(Source.PackageName, nullptr, &Source.PackageFilename);
+}
+
+struct FStaticMeshSource : FAssetSource
+{
+	using FResource = ns_yoyo::FStaticMeshResource;
+	TArray<FStaticMeshLODResources*> LODResources;
+	TArray<float> ScreenSizes;
+	TArray<ns_yoyo::FMaterialInfo> Materials;
+	// package files of the materials and their parents, hashed with the mesh's
+	TArray<FString> MaterialPackageFilenames;
+	// referenced by the materials, exported next to the mesh
+	TSet<UTexture2D*> Textures;
+	ns_yoyo::FVertexLayout VertexLayout;
+	bool bOptimize = false;
+	bool bBuildMeshlets = false;
+};
+
+struct FSkeletalMeshSource : FAssetSource
+{
+	using FResource = ns_yoyo::FSkeletalMeshResource;
+	FString SkelAssetPath;
+	TArray<FSkeletalMeshLODRenderData*> LODRenderData;
+	TArray<float> ScreenSizes;
+	TArray<ns_yoyo::FMaterialInfo> Materials;
+	// package files of the materials and their parents, hashed with the mesh's
+	TArray<FString> MaterialPackageFilenames;
+	// referenced by the materials, exported next to the mesh
+	TSet<UTexture2D*> Textures;
+	ns_yoyo::FVertexLayout VertexLayout;
+	bool bOptimize = false;
+	bool bBuildMeshlets = false;
+	bool bPackSkinWeights = false;
+};
+
+struct FAnimSequenceSource : FAssetSource
+{
+	using FResource = ns_yoyo::FAnimSequenceResource;
+	FString SkelAssetPath;
+	int32 NumFrames = 0;
+	float SequenceLength = 0.f;
+	const TArray<FRawAnimSequenceTrack>* BoneTracks = nullptr;
+	const TArray<FName>* TrackNames = nullptr;
+	TArray<int32> TrackToBoneIndices;
+	// 0 keeps the source keys
+	float SampleRate = 0.f;
+	ns_yoyo::FAnimSequenceResource::EBakedSpace BakedSpace = ns_yoyo::FAnimSequenceResource::EBakedSpace::None;
+	// bind pose the matrices are baked against
+	const FReferenceSkeleton* ReferenceSkel = nullptr;
+	// package file of the skeleton, hashed with the animation's when baking
+	FString SkeletonPackageFilename;
+	bool bCompress = false;
+	ns_yoyo::FAnimCompressionSettings CompressionSettings;
+};
+
+struct FSkeletonSource : FAssetSource
+{
+	using FResource = ns_yoyo::FSkeleton;
+	const FReferenceSkeleton* ReferenceSkel = nullptr;
+};
+
+struct FTextureSource : FAssetSource
+{
+	using FResource = ns_yoyo::FTextureResource;
+	EPixelFormat PixelFormat = PF_Unknown;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	// loaded on the game thread, the first ones when some can't be
+	TArray<TArray<uint8>> Mips;
+	bool bSRGB = false;
+};
+
+// the mesh every animation of an ExportVertexAnimations call bakes onto, built once by the first job needing it
+struct FVertexAnimationMesh
+{
+	// built as exported, so the vertices are in the order of the exported mesh, holding the baked LOD only,
+	// or with the optimizer on, the exported LODs it may share a vertex buffer with too
+	FSkeletalMeshSource Source;
+	// of the baked LOD, into the exported LODs and into Source.LODRenderData
+	int32 ExportedLODIndex = 0;
+	int32 BuiltLODIndex = 0;
+	// read only once built
+	ns_yoyo::FSkeletalMeshResource Resource;
+	bool bBuilt = false;
+	FCriticalSection BuildLock;
+};
+
+struct FVertexAnimationSource : FAssetSource
+{
+	using FResource = ns_yoyo::FVertexAnimationResource;
+	TSharedPtr<FVertexAnimationMesh, ESPMode::ThreadSafe> Mesh;
+	// baked into skinning matrices against the mesh's reference skeleton
+	FAnimSequenceSource Anim;
+};
+
+// the values a material resolves its parameters to, the 2D textures it samples are added to Textures
+static void GatherMaterial(UMaterialInterface* Material, FName SlotName, ns_yoyo::FMaterialInfo& OutMaterial, TSet<UTexture2D*>& Textures)
+{
+	OutMaterial.SlotName = SlotName.ToString();
+	if (!Material)
+	{
+		return;
+	}
+	OutMaterial.MaterialPath = Material->GetPathName();
+
+	TArray<FMaterialParameterInfo> ParameterInfos;
+	TArray<FGuid> ParameterIds;
+	Material->GetAllScalarParameterInfo(ParameterInfos, ParameterIds);
+	for (const FMaterialParameterInfo& ParameterInfo : ParameterInfos)
+	{
+		float Value = 0.f;
+		if (Material->GetScalarParameterValue(FHashedMaterialParameterInfo(ParameterInfo), Value))
+		{
+			OutMaterial.ScalarParameters.Add({ ParameterInfo.Name.ToString(), Value });
+		}
+	}
+	ParameterInfos.Reset();
+	ParameterIds.Reset();
+	Material->GetAllVectorParameterInfo(ParameterInfos, ParameterIds);
+	for (const FMaterialParameterInfo& ParameterInfo : ParameterInfos)
+	{
+		FLinearColor Value = FLinearColor::Black;
+		if (Material->GetVectorParameterValue(FHashedMaterialParameterInfo(ParameterInfo), Value))
+		{
+			OutMaterial.VectorParameters.Add({ ParameterInfo.Name.ToString(), Value });
+		}
+	}
+
+	TSet<UTexture*> ListedTextures;
+	auto AddTexture = [&OutMaterial, &Textures, &ListedTextures](const FString& Name, UTexture* Texture)
+	{
+		UTexture2D* Texture2D = Cast<UTexture2D>(Texture);
+		if (!Texture2D)
+		{
+			return;
+		}
+		ListedTextures.Add(Texture);
+		OutMaterial.Textures.Add({ Name, GetAssetPath<ns_yoyo::EResourceType::Texture>(Texture2D) });
+		Textures.Add(Texture2D);
+	};
+	ParameterInfos.Reset();
+	ParameterIds.Reset();
+	Material->GetAllTextureParameterInfo(ParameterInfos, ParameterIds);
+	for (const FMaterialParameterInfo& ParameterInfo : ParameterInfos)
+	{
+		UTexture* Texture = nullptr;
+		if (Material->GetTextureParameterValue(FHashedMaterialParameterInfo(ParameterInfo), Texture))
+		{
+			AddTexture(ParameterInfo.Name.ToString(), Texture);
+		}
+	}
+	// sampled without a parameter
+	TArray<UTexture*> UsedTextures;
+	Material->GetUsedTextures(UsedTextures, EMaterialQualityLevel::Num, true, GMaxRHIFeatureLevel, true);
+	for (UTexture* Texture : UsedTextures)
+	{
+		if (!ListedTextures.Contains(Texture))
+		{
+			AddTexture(FString(), Texture);
+		}
+	}
+}
+
+// the package files of a material and of every parent it resolves its parameters from
+static void GatherMaterialPackages(UMaterialInterface* Material, TArray<FString>& PackageFilenames)
+{
+	while (Material)
+	{
+		FAssetSource MaterialSource;
+		GatherPackage(Material, MaterialSource);
+		PackageFilenames.AddUnique(MaterialSource.PackageFilename);
+		UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Material);
+		Material = MaterialInstance ? MaterialInstance->Parent : nullptr;
+	}
+}
+
+static FStaticMeshSource GatherStaticMesh(UStaticMesh* Mesh, ns_yoyo::FExportReport* Report = nullptr)
+{
+	// check and get the lod resources
+	check(Mesh && Mesh->RenderData && Mesh->RenderData->LODResources.Num() > 0);
+	FStaticMeshSource Source;
+	Source.Path = GetAssetPath<ns_yoyo::EResourceType::StaticMesh>(Mesh);
+	AddReportRecord(Report, ns_yoyo::EResourceType::StaticMesh, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	GatherPackage(Mesh, Source);
+	for (int32 LODIndex : GetExportedLODs(Mesh->RenderData->LODResources.Num()))
+	{
+		Source.LODResources.Add(&Mesh->RenderData->LODResources[LODIndex]);
+		Source.ScreenSizes.Add(Mesh->RenderData->ScreenSize[LODIndex].Default);
+	}
+	Source.VertexLayout = GetVertexLayout();
+	Source.bOptimize = CVarExportOptimizeMeshes.GetValueOnGameThread() != 0;
+	Source.bBuildMeshlets = CVarExportBuildMeshlets.GetValueOnGameThread() != 0;
+	for (const FStaticMaterial& StaticMaterial : Mesh->StaticMaterials)
+	{
+		GatherMaterial(StaticMaterial.MaterialInterface, StaticMaterial.MaterialSlotName, Source.Materials.AddDefaulted_GetRef(), Source.Textures);
+		GatherMaterialPackages(StaticMaterial.MaterialInterface, Source.MaterialPackageFilenames);
+	}
+	return Source;
+}
+
+static FSkeletalMeshSource GatherSkeletalMesh(USkeletalMesh* SkelMesh, ns_yoyo::FExportReport* Report = nullptr)
+{
+	check(SkelMesh);
+	FSkeletalMeshRenderData* RenderData = SkelMesh->GetResourceForRendering();
+	check(RenderData && RenderData->LODRenderData.Num() > 0);
+	FSkeletalMeshSource Source;
+	Source.Path = GetAssetPath<ns_yoyo::EResourceType::SkeletalMesh>(SkelMesh);
+	AddReportRecord(Report, ns_yoyo::EResourceType::SkeletalMesh, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	GatherPackage(SkelMesh, Source);
+	Source.SkelAssetPath = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(SkelMesh->Skeleton);
+	for (int32 LODIndex : GetExportedLODs(RenderData->LODRenderData.Num()))
+	{
+		const FSkeletalMeshLODInfo* LODInfo = SkelMesh->GetLODInfo(LODIndex);
+		Source.LODRenderData.Add(&RenderData->LODRenderData[LODIndex]);
+		Source.ScreenSizes.Add(LODInfo ? LODInfo->ScreenSize.Default : 0.f);
+	}
+	Source.VertexLayout = GetVertexLayout();
+	Source.bOptimize = CVarExportOptimizeMeshes.GetValueOnGameThread() != 0;
+	Source.bBuildMeshlets = CVarExportBuildMeshlets.GetValueOnGameThread() != 0;
+	Source.bPackSkinWeights = CVarExportPackedSkinWeights.GetValueOnGameThread() != 0;
+	for (const FSkeletalMaterial& SkeletalMaterial : SkelMesh->Materials)
+	{
+		GatherMaterial(SkeletalMaterial.MaterialInterface, SkeletalMaterial.MaterialSlotName, Source.Materials.AddDefaulted_GetRef(), Source.Textures);
+		GatherMaterialPackages(SkeletalMaterial.MaterialInterface, Source.MaterialPackageFilenames);
+	}
+	return Source;
+}
+
+static FAnimSequenceSource GatherAnimSequence(UAnimSequence* AnimSequence, ns_yoyo::FExportReport* Report = nullptr)
+{
+	check(AnimSequence);
+	USkeleton* Skeleton = AnimSequence->GetSkeleton();
+	check(Skeleton);
+	FAnimSequenceSource Source;
+	Source.Path = GetAssetPath<ns_yoyo::EResourceType::AnimSequence>(AnimSequence);
+	AddReportRecord(Report, ns_yoyo::EResourceType::AnimSequence, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	GatherPackage(AnimSequence, Source);
+	Source.SkelAssetPath = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(Skeleton);
+	Source.NumFrames = AnimSequence->GetRawNumberOfFrames();
+	Source.SequenceLength = AnimSequence->SequenceLength;
+	Source.BoneTracks = &AnimSequence->GetRawAnimationData();
+	Source.TrackNames = &AnimSequence->GetAnimationTrackNames();
+	for (const FTrackToSkeletonMap& TrackToSkeleton : AnimSequence->GetRawTrackToSkeletonMapTable())
+	{
+		Source.TrackToBoneIndices.Add(TrackToSkeleton.BoneTreeIndex);
+	}
+	Source.SampleRate = FMath::Max(CVarExportAnimSampleRate.GetValueOnGameThread(), 0.f);
+	Source.BakedSpace = (ns_yoyo::FAnimSequenceResource::EBakedSpace)FMath::Clamp(CVarExportAnimBakeMatrices.GetValueOnGameThread(),
+		0, (int32)ns_yoyo::FAnimSequenceResource::EBakedSpace::Max - 1);
+	Source.ReferenceSkel = &Skeleton->GetReferenceSkeleton();
+	FAssetSource SkeletonSource;
+	GatherPackage(Skeleton, SkeletonSource);
+	Source.SkeletonPackageFilename = SkeletonSource.PackageFilename;
+	Source.bCompress = CVarExportCompressAnimations.GetValueOnGameThread() != 0;
+	Source.CompressionSettings.PositionTolerance = CVarExportAnimPositionTolerance.GetValueOnGameThread();
+	Source.CompressionSettings.RotationTolerance = CVarExportAnimRotationTolerance.GetValueOnGameThread();
+	Source.CompressionSettings.ScaleTolerance = CVarExportAnimScaleTolerance.GetValueOnGameThread();
+	return Source;
+}
+
+static FSkeletonSource GatherSkeleton(USkeleton* Skeleton, ns_yoyo::FExportReport* Report = nullptr)
+{
+	check(Skeleton);
+	FSkeletonSource Source;
+	Source.Path = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(Skeleton);
+	AddReportRecord(Report, ns_yoyo::EResourceType::Skeleton, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	GatherPackage(Skeleton, Source);
+	Source.ReferenceSkel = &Skeleton->GetReferenceSkeleton();
+	return Source;
+}
+
+static bool CanExportTexture(UTexture2D* Texture)
+{
+	return Texture->PlatformData && Texture->PlatformData->Mips.Num() > 0
+		&& ns_yoyo::GetTextureFormat(Texture->PlatformData->PixelFormat) != ns_yoyo::ETextureFormat::Max;
+}
+
+static FTextureSource GatherTexture(UTexture2D* Texture, ns_yoyo::FExportReport* Report = nullptr)
+{
+	check(Texture && CanExportTexture(Texture));
+	FTextureSource Source;
+	Source.Path = GetAssetPath<ns_yoyo::EResourceType::Texture>(Texture);
+	AddReportRecord(Report, ns_yoyo::EResourceType::Texture, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	GatherPackage(Texture, Source);
+	Source.PixelFormat = Texture->PlatformData->PixelFormat;
+	Source.SizeX = Texture->PlatformData->SizeX;
+	Source.SizeY = Texture->PlatformData->SizeY;
+	Source.bSRGB = Texture->SRGB;
+
+	// from the bulk data or the derived data cache, which may go through the linker or rebuild the platform data
+	const ns_yoyo::ETextureFormat Format = ns_yoyo::GetTextureFormat(Source.PixelFormat);
+	const int32 NumMips = Texture->PlatformData->Mips.Num();
+	TArray<void*> MipData;
+	MipData.AddZeroed(NumMips);
+	const bool bAllLoaded = Texture->GetMipData(0, MipData.GetData());
+	for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+	{
+		// exactly what TranscodeMips reads of the mip
+		const int64 MipSize = ns_yoyo::GetMipSize(Format, FMath::Max(Source.SizeX >> MipIndex, 1), FMath::Max(Source.SizeY >> MipIndex, 1));
+		if (!MipData[MipIndex] || Texture->PlatformData->Mips[MipIndex].BulkData.GetBulkDataSize() < MipSize)
+		{
+			break;
+		}
+		Source.Mips.Emplace(static_cast<const uint8*>(MipData[MipIndex]), (int32)MipSize);
+	}
+	for (void* Data : MipData)
+	{
+		FMemory::Free(Data);
+	}
+	if (!bAllLoaded || Source.Mips.Num() < NumMips)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s has %d of %d mips loaded, exported the first ones"), *Source.Path, Source.Mips.Num(), NumMips);
+	}
+	return Source;
+}
+
+// <Mesh>/<Anim>.vat, an animation bakes onto any number of meshes
+static FString GetVertexAnimationPath(USkeletalMesh* SkelMesh, UAnimSequence* AnimSequence)
+{
+	return FPaths::GetBaseFilename(GetAssetPath<ns_yoyo::EResourceType::SkeletalMesh>(SkelMesh), false)
+		/ AnimSequence->GetName() + TEXT(".vat");
+}
+
+static TSharedRef<FVertexAnimationMesh, ESPMode::ThreadSafe> GatherVertexAnimationMesh(USkeletalMesh* SkelMesh)
+{
+	TSharedRef<FVertexAnimationMesh, ESPMode::ThreadSafe> Mesh = MakeShared<FVertexAnimationMesh, ESPMode::ThreadSafe>();
+	Mesh->Source = GatherSkeletalMesh(SkelMesh);
+	Mesh->Source.bBuildMeshlets = false;
+	FSkeletalMeshSource& Source = Mesh->Source;
+	const int32 NumLODs = Source.LODRenderData.Num();
+	const int32 LODIndex = CVarExportVertexAnimationLOD.GetValueOnGameThread();
+	Mesh->ExportedLODIndex = LODIndex == INDEX_NONE ? NumLODs - 1 : FMath::Clamp(LODIndex, 0, NumLODs - 1);
+
+	// the optimizer orders the vertices of a buffer for every LOD drawing from it,
+	// only LODs of as many vertices can share the buffer of the baked one
+	const FSkeletalMeshLODRenderData* BakedLOD = Source.LODRenderData[Mesh->ExportedLODIndex];
+	TArray<FSkeletalMeshLODRenderData*> LODRenderData;
+	TArray<float> ScreenSizes;
+	for (int32 i = 0; i < NumLODs; ++i)
+	{
+		if (i == Mesh->ExportedLODIndex)
+		{
+			Mesh->BuiltLODIndex = LODRenderData.Num();
+		}
+		else if (!Source.bOptimize || Source.LODRenderData[i]->GetNumVertices() != BakedLOD->GetNumVertices())
+		{
+			continue;
+		}
+		LODRenderData.Add(Source.LODRenderData[i]);
+		ScreenSizes.Add(Source.ScreenSizes[i]);
+	}
+	Source.LODRenderData = MoveTemp(LODRenderData);
+	Source.ScreenSizes = MoveTemp(ScreenSizes);
+	return Mesh;
+}
+
+static FVertexAnimationSource GatherVertexAnimation(const TSharedRef<FVertexAnimationMesh, ESPMode::ThreadSafe>& Mesh,
+	USkeletalMesh* SkelMesh, UAnimSequence* AnimSequence, ns_yoyo::FExportReport* Report = nullptr)
+{
+	check(SkelMesh && AnimSequence && AnimSequence->GetSkeleton());
+	FVertexAnimationSource Source;
+	Source.Path = GetVertexAnimationPath(SkelMesh, AnimSequence);
+	AddReportRecord(Report, ns_yoyo::EResourceType::VertexAnimation, Source);
+	EXPORT_STAGE_SCOPE(Source.Record, Gather);
+	// the mesh and the animation are both sources, the manifest hashes the two packages
+	GatherPackage(SkelMesh, Source);
+	Source.Mesh = Mesh;
+	Source.Anim = GatherAnimSequence(AnimSequence);
+	Source.Anim.bCompress = false;
+	Source.Anim.BakedSpace = ns_yoyo::FAnimSequenceResource::EBakedSpace::Skinning;
+	Source.Anim.ReferenceSkel = &SkelMesh->RefSkeleton;
+	Source.Anim.Record = Source.Record;
+	// tracks animate bones of the skeleton asset, the mesh may have fewer of them in another order
+	const FReferenceSkeleton& SkeletonRef = AnimSequence->GetSkeleton()->GetReferenceSkeleton();
+	for (int32& BoneIndex : Source.Anim.TrackToBoneIndices)
+	{
+		BoneIndex = SkeletonRef.IsValidIndex(BoneIndex) ? SkelMesh->RefSkeleton.FindBoneIndex(SkeletonRef.GetBoneName(BoneIndex)) : INDEX_NONE;
+	}
+	return Source;
+}
+
+static void LogVertexCacheStats(const FString& Path, const ns_yoyo::FVertexCacheStats& Before, const ns_yoyo::FVertexCacheStats& After)
+{
+	UE_LOG(LogTemp, Log, TEXT("%s vertex cache (fifo %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f"),
+		*Path, ns_yoyo::VertexCacheAnalyzeSize, Before.ACMR, After.ACMR, Before.ATVR, After.ATVR);
+}
+
+// LODs UE built from the same vertices export identical buffers, those are stored once
+static bool IsSameVertexBuffer(const ns_yoyo::FVertexBuffer& A, const ns_yoyo::FVertexBuffer& B)
+{
+	return A.NumVertices == B.NumVertices
+		&& A.Layout == B.Layout
+		&& A.PositionOffset == B.PositionOffset
+		&& A.PositionScale == B.PositionScale
+		&& A.RawData == B.RawData;
+}
+
+static void BuildResource(const FStaticMeshSource& Source, ns_yoyo::FStaticMeshResource& yyMeshResource)
+{
+	// build resource path
+	yyMeshResource.Path = Source.Path;
+
+	uint32 MaxVertices = 0;
+	uint32 NumTriangles = 0;
+	for (int32 i = 0; i < Source.LODResources.Num(); ++i)
+	{
+		FStaticMeshLODResources& LODResource = *Source.LODResources[i];
+		ns_yoyo::FStaticMeshLOD& yyLOD = yyMeshResource.LODs.AddDefaulted_GetRef();
+		yyLOD.ScreenSize = Source.ScreenSizes[i];
+
+		// vertex buffer
+		{
+			EXPORT_STAGE_SCOPE(Source.Record, VertexBuffer);
+			ns_yoyo::FVertexBuffer yyVertexBuffer;
+			ns_yoyo::ExportVertexBuffer(yyVertexBuffer, LODResource.VertexBuffers, Source.VertexLayout);
+			yyLOD.VertexBufferIndex = yyMeshResource.VertexBuffers.IndexOfByPredicate([&yyVertexBuffer](const ns_yoyo::FVertexBuffer& Other)
+			{
+				return IsSameVertexBuffer(yyVertexBuffer, Other);
+			});
+			if (yyLOD.VertexBufferIndex == INDEX_NONE)
+			{
+				MaxVertices = FMath::Max(MaxVertices, yyVertexBuffer.NumVertices);
+				yyLOD.VertexBufferIndex = yyMeshResource.VertexBuffers.Add(MoveTemp(yyVertexBuffer));
+			}
+		}
+
+		// index buffer
+		{
+			EXPORT_STAGE_SCOPE(Source.Record, IndexBuffer);
+			ns_yoyo::FIndexBuffer yyIndexBuffer;
+			ns_yoyo::ExportStaticIndexBuffer(yyIndexBuffer, LODResource.IndexBuffer, LODResource.GetNumVertices());
+			check(yyIndexBuffer.NumIndices == LODResource.GetNumTriangles() * 3);
+			yyLOD.FirstIndex = yyMeshResource.IndexBuffer.BufferData.Num();
+			yyLOD.NumIndices = yyIndexBuffer.NumIndices;
+			yyMeshResource.IndexBuffer.BufferData.Append(yyIndexBuffer.BufferData);
+		}
+		NumTriangles += LODResource.GetNumTriangles();
+
+		// sections, FirstIndex into the index buffer of the whole mesh
+		for (auto& ueSection : LODResource.Sections)
+		{
+			ns_yoyo::FStaticMeshSection yySection;
+			yySection.FirstIndex = yyLOD.FirstIndex + ueSection.FirstIndex;
+			yySection.MaterialIndex = ueSection.MaterialIndex;
+			yySection.MaxVertexIndex = ueSection.MaxVertexIndex;
+			yySection.MinVertexIndex = ueSection.MinVertexIndex;
+			yySection.NumTriangles = ueSection.NumTriangles;
+			yySection.bCastShadow = ueSection.bCastShadow;
+			yyLOD.Sections.Add(yySection);
+		}
+	}
+	yyMeshResource.IndexBuffer.NumIndices = yyMeshResource.IndexBuffer.BufferData.Num();
+	yyMeshResource.IndexBuffer.SetIndexWidthForVertices(MaxVertices);
+	yyMeshResource.Materials = Source.Materials;
+
+	if (Source.Record)
+	{
+		for (const ns_yoyo::FVertexBuffer& yyVertexBuffer : yyMeshResource.VertexBuffers)
+		{
+			Source.Record->NumVertices += yyVertexBuffer.NumVertices;
+		}
+		Source.Record->NumTriangles = NumTriangles;
+	}
+
+	// optimize
+	if (Source.bOptimize)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Optimize);
+		ns_yoyo::FVertexCacheStats Before, After;
+		ns_yoyo::OptimizeStaticMesh(yyMeshResource, Before, After);
+		LogVertexCacheStats(Source.Path, Before, After);
+	}
+
+	// meshlets, after optimizing so they follow the final triangle and vertex order
+	if (Source.bBuildMeshlets)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Meshlets);
+		ns_yoyo::BuildStaticMeshMeshlets(yyMeshResource);
+	}
+}
+
+static void BuildResource(const FSkeletalMeshSource& Source, ns_yoyo::FSkeletalMeshResource& yySkeletalMeshResource)
+{
+	// fill the path
+	yySkeletalMeshResource.Path = Source.Path;
+	yySkeletalMeshResource.SkelAssetPath = Source.SkelAssetPath;
+	yySkeletalMeshResource.Materials = Source.Materials;
+
+	uint32 MaxVertices = 0;
+	uint32 NumTriangles = 0;
+	for (int32 i = 0; i < Source.LODRenderData.Num(); ++i)
+	{
+		FSkeletalMeshLODRenderData& LODData = *Source.LODRenderData[i];
+		ns_yoyo::FSkeletalMeshLOD& yyLOD = yySkeletalMeshResource.LODs.AddDefaulted_GetRef();
+		yyLOD.ScreenSize = Source.ScreenSizes[i];
+
+		// vertex buffer
+		ns_yoyo::FVertexBuffer yyVertexBuffer;
+		{
+			EXPORT_STAGE_SCOPE(Source.Record, VertexBuffer);
+			ns_yoyo::ExportVertexBuffer(yyVertexBuffer, LODData.StaticVertexBuffers, Source.VertexLayout);
+		}
+
+		// skin weight buffer
+		ns_yoyo::FSkinWeightBuffer yySkinWeightBuffer;
+		{
+			EXPORT_STAGE_SCOPE(Source.Record, SkinWeights);
+			uint32 MaxBoneInfluences = 0;
+			uint32 MaxSectionBones = 0;
+			for (const FSkelMeshRenderSection& ueSection : LODData.RenderSections)
+			{
+				MaxBoneInfluences = FMath::Max<uint32>(MaxBoneInfluences, ueSection.MaxBoneInfluences);
+				MaxSectionBones = FMath::Max<uint32>(MaxSectionBones, ueSection.BoneMap.Num());
+			}
+			ns_yoyo::ExportSkinWeightBuffer(yySkinWeightBuffer, *LODData.GetSkinWeightVertexBuffer(),
+				MaxBoneInfluences, MaxSectionBones, Source.bPackSkinWeights);
+		}
+
+		// shared when both the vertices and their weights match an earlier LOD
+		yyLOD.VertexBufferIndex = INDEX_NONE;
+		for (int32 BufferIndex = 0; BufferIndex < yySkeletalMeshResource.VertexBuffers.Num(); ++BufferIndex)
+		{
+			const ns_yoyo::FSkinWeightBuffer& OtherWeights = yySkeletalMeshResource.SkinWeightBuffers[BufferIndex];
+			if (IsSameVertexBuffer(yyVertexBuffer, yySkeletalMeshResource.VertexBuffers[BufferIndex])
+				&& OtherWeights.NumInfluences == yySkinWeightBuffer.NumInfluences
+				&& OtherWeights.BoneIndexSize == yySkinWeightBuffer.BoneIndexSize
+				&& OtherWeights.RawData == yySkinWeightBuffer.RawData)
+			{
+				yyLOD.VertexBufferIndex = BufferIndex;
+				break;
+			}
+		}
+		if (yyLOD.VertexBufferIndex == INDEX_NONE)
+		{
+			MaxVertices = FMath::Max(MaxVertices, yyVertexBuffer.NumVertices);
+			yyLOD.VertexBufferIndex = yySkeletalMeshResource.VertexBuffers.Add(MoveTemp(yyVertexBuffer));
+			yySkeletalMeshResource.SkinWeightBuffers.Add(MoveTemp(yySkinWeightBuffer));
+		}
+
+		// fill the sections, BaseIndex into the index buffer of the whole mesh
+		uint32 NumLODTriangles = 0;
+		for (FSkelMeshRenderSection& ueSection : LODData.RenderSections)
+		{
+			ns_yoyo::FSkelMeshRenderSection yySkelMeshRenderSection;
+			yySkelMeshRenderSection.BaseIndex = yySkeletalMeshResource.IndexBuffer.BufferData.Num() + ueSection.BaseIndex;
+			yySkelMeshRenderSection.BaseVertexIndex = ueSection.BaseVertexIndex;
+			yySkelMeshRenderSection.bCastShadow = ueSection.bCastShadow;
+			yySkelMeshRenderSection.MaterialIndex = ueSection.MaterialIndex;
+			yySkelMeshRenderSection.MaxBoneInfluences = ueSection.MaxBoneInfluences;
+			yySkelMeshRenderSection.NumTriangles = ueSection.NumTriangles;
+			yySkelMeshRenderSection.NumVertices = ueSection.NumVertices;
+			yySkelMeshRenderSection.BoneMap.Reserve(ueSection.BoneMap.Num());
+			for (auto& BoneIndex : ueSection.BoneMap)
+			{
+				yySkelMeshRenderSection.BoneMap.Add(BoneIndex);
+			}
+			yyLOD.RenderSections.Add(yySkelMeshRenderSection);
+			NumLODTriangles += ueSection.NumTriangles;
+		}
+		NumTriangles += NumLODTriangles;
+
+		// index buffer
+		{
+			EXPORT_STAGE_SCOPE(Source.Record, IndexBuffer);
+			ns_yoyo::FIndexBuffer yyIndexBuffer;
+			ns_yoyo::ExportMultiSizeIndexContainer(yyIndexBuffer, LODData.MultiSizeIndexContainer, LODData.GetNumVertices());
+			check(yyIndexBuffer.NumIndices == NumLODTriangles * 3);
+			yyLOD.FirstIndex = yySkeletalMeshResource.IndexBuffer.BufferData.Num();
+			yyLOD.NumIndices = yyIndexBuffer.NumIndices;
+			yySkeletalMeshResource.IndexBuffer.BufferData.Append(yyIndexBuffer.BufferData);
+		}
+	}
+	yySkeletalMeshResource.IndexBuffer.NumIndices = yySkeletalMeshResource.IndexBuffer.BufferData.Num();
+	yySkeletalMeshResource.IndexBuffer.SetIndexWidthForVertices(MaxVertices);
+
+	if (Source.Record)
+	{
+		for (const ns_yoyo::FVertexBuffer& yyVertexBuffer : yySkeletalMeshResource.VertexBuffers)
+		{
+			Source.Record->NumVertices += yyVertexBuffer.NumVertices;
+		}
+		Source.Record->NumTriangles = NumTriangles;
+	}
+
+	// optimize, vertices move together with their skin weights
+	if (Source.bOptimize)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Optimize);
+		ns_yoyo::FVertexCacheStats Before, After;
+		ns_yoyo::OptimizeSkeletalMesh(yySkeletalMeshResource, Before, After);
+		LogVertexCacheStats(Source.Path, Before, After);
+	}
+
+	// meshlets, after optimizing so they follow the final triangle and vertex order
+	if (Source.bBuildMeshlets)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Meshlets);
+		ns_yoyo::BuildSkeletalMeshMeshlets(yySkeletalMeshResource);
+	}
+}
+
+static void BuildResource(const FSkeletonSource& Source, ns_yoyo::FSkeleton& yySkeleton)
+{
+	const FReferenceSkeleton& ReferenceSkel = *Source.ReferenceSkel;
+	const TArray<FMeshBoneInfo>& BoneInfo = ReferenceSkel.GetRawRefBoneInfo();
+	const TArray<FTransform>& BonePose = ReferenceSkel.GetRawRefBonePose();
+
+	yySkeleton.Path = Source.Path;
+	yySkeleton.BoneInfos.AddZeroed(BoneInfo.Num());
+	for (int32 i = 0; i < BoneInfo.Num(); ++i)
+	{
+		yySkeleton.BoneInfos[i].Name = BoneInfo[i].ExportName;
+		yySkeleton.BoneInfos[i].ParentIndex = BoneInfo[i].ParentIndex;
+	}
+	yySkeleton.BonePoses.AddZeroed(BonePose.Num());
+	for (int32 i = 0; i < BonePose.Num(); ++i)
+	{
+		//yySkeleton.BonePoses[i].Rot = ns_yoyo::Quat2Vec4(BonePose[i].Rotator().Quaternion());
+		yySkeleton.BonePoses[i].Rot = BonePose[i].Rotator().Quaternion();
+		yySkeleton.BonePoses[i].Trans = BonePose[i].GetLocation();
+		yySkeleton.BonePoses[i].Scale = BonePose[i].GetScale3D();
+	}
+}
+
+static void BuildResource(const FAnimSequenceSource& Source, ns_yoyo::FAnimSequenceResource& yyAnimSequence)
+{
+	const TArray<FRawAnimSequenceTrack>& BoneTracks = *Source.BoneTracks;
+
+	yyAnimSequence.Path = Source.Path;
+	yyAnimSequence.NumFrames = Source.NumFrames;
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Animation);
+		yyAnimSequence.RawAnimationData.AddZeroed(BoneTracks.Num());
+		for (int32 i = 0; i < BoneTracks.Num(); ++i)
+		{
+			yyAnimSequence.RawAnimationData[i].PosKeys = BoneTracks[i].PosKeys;
+			yyAnimSequence.RawAnimationData[i].RotKeys = BoneTracks[i].RotKeys;
+			yyAnimSequence.RawAnimationData[i].ScaleKeys = BoneTracks[i].ScaleKeys;
+		}
+	}
+	yyAnimSequence.FrameRate = Source.NumFrames > 1 && Source.SequenceLength > 0.f ? (Source.NumFrames - 1) / Source.SequenceLength : 30.f;
+	yyAnimSequence.TrackToBoneIndices = Source.TrackToBoneIndices;
+	yyAnimSequence.SkelAssetPath = Source.SkelAssetPath;
+
+	// resample, then bake the matrices from the raw keys before they are compressed
+	if (Source.SampleRate > 0.f || Source.BakedSpace != ns_yoyo::FAnimSequenceResource::EBakedSpace::None)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, AnimSampling);
+		if (Source.SampleRate > 0.f)
+		{
+			ns_yoyo::ResampleAnimSequence(yyAnimSequence, Source.SequenceLength, Source.SampleRate);
+		}
+		if (Source.BakedSpace != ns_yoyo::FAnimSequenceResource::EBakedSpace::None)
+		{
+			FSkeletonSource SkeletonSource;
+			SkeletonSource.ReferenceSkel = Source.ReferenceSkel;
+			ns_yoyo::FSkeleton yySkeleton;
+			BuildResource(SkeletonSource, yySkeleton);
+			ns_yoyo::BakeBoneMatrices(yyAnimSequence, yySkeleton, Source.BakedSpace);
+		}
+	}
+
+	// compress
+	if (Source.bCompress)
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, AnimCompression);
+		const uint64 RawSize = ns_yoyo::GetAnimationDataSize(yyAnimSequence);
+		TArray<ns_yoyo::FAnimTrackError> Errors;
+		if (!ns_yoyo::CompressAnimSequence(yyAnimSequence, Source.CompressionSettings, Errors))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s has too many frames to compress (%d), exported raw"), *Source.Path, yyAnimSequence.NumFrames);
+			return;
+		}
+		int32 WorstTrack = 0;
+		for (int32 i = 0; i < Errors.Num(); ++i)
+		{
+			const FName TrackName = Source.TrackNames->IsValidIndex(i) ? (*Source.TrackNames)[i] : NAME_None;
+			UE_LOG(LogTemp, Verbose, TEXT("%s bone %s max error: position %.4f, rotation %.4f deg, scale %.5f"),
+				*Source.Path, *TrackName.ToString(), Errors[i].Position, Errors[i].Rotation, Errors[i].Scale);
+			if (Errors[i].Rotation > Errors[WorstTrack].Rotation)
+			{
+				WorstTrack = i;
+			}
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s animation keys %llu -> %llu bytes, worst rotation error %.4f deg"),
+			*Source.Path, RawSize, ns_yoyo::GetAnimationDataSize(yyAnimSequence), Errors.Num() > 0 ? Errors[WorstTrack].Rotation : 0.f);
+	}
+}
+
+static void BuildResource(const FTextureSource& Source, ns_yoyo::FTextureResource& yyTexture)
+{
+	yyTexture.Path = Source.Path;
+	yyTexture.Format = ns_yoyo::GetTextureFormat(Source.PixelFormat);
+	yyTexture.bSRGB = Source.bSRGB;
+
+	EXPORT_STAGE_SCOPE(Source.Record, Texture);
+	TArray<const void*> MipData;
+	for (const TArray<uint8>& Mip : Source.Mips)
+	{
+		MipData.Add(Mip.GetData());
+	}
+	ns_yoyo::TranscodeMips(yyTexture, Source.PixelFormat, Source.SizeX, Source.SizeY, MipData);
+}
+
+// builds the mesh on the first call, the stages timed into the record of the job doing it
+static const ns_yoyo::FSkeletalMeshResource& GetBuiltMesh(FVertexAnimationMesh& Mesh, ns_yoyo::FAssetExportRecord* Record)
+{
+	FScopeLock ScopeLock(&Mesh.BuildLock);
+	if (!Mesh.bBuilt)
+	{
+		// other jobs read the shared source while this one builds
+		FSkeletalMeshSource Source = Mesh.Source;
+		Source.Record = Record;
+		BuildResource(Source, Mesh.Resource);
+		Mesh.bBuilt = true;
+	}
+	return Mesh.Resource;
+}
+
+static void BuildResource(const FVertexAnimationSource& Source, ns_yoyo::FVertexAnimationResource& yyVertexAnimation)
+{
+	const ns_yoyo::FSkeletalMeshResource& yySkeletalMesh = GetBuiltMesh(*Source.Mesh, Source.Record);
+	ns_yoyo::FAnimSequenceResource yyAnimSequence;
+	BuildResource(Source.Anim, yyAnimSequence);
+
+	EXPORT_STAGE_SCOPE(Source.Record, VertexAnimation);
+	yyVertexAnimation.Path = Source.Path;
+	yyVertexAnimation.SkelMeshPath = Source.Mesh->Source.Path;
+	yyVertexAnimation.AnimSeqPath = Source.Anim.Path;
+	if (!ns_yoyo::BakeVertexAnimation(yyVertexAnimation, yySkeletalMesh, Source.Mesh->BuiltLODIndex, yyAnimSequence))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s LOD %d can't be skinned by %s, exported empty"),
+			*Source.Mesh->Source.Path, Source.Mesh->ExportedLODIndex, *Source.Anim.Path);
+		return;
+	}
+	// the LOD of the exported mesh, not of the one built here
+	yyVertexAnimation.LODIndex = Source.Mesh->ExportedLODIndex;
+	UE_LOG(LogTemp, Log, TEXT("%s %u vertices x %d frames"), *Source.Path, yyVertexAnimation.NumVertices, yyVertexAnimation.NumFrames);
+}
+
+// moves the data of a buffer into a blob of the session, leaving its path behind and adding it to BlobPaths
+static void ShareBlob(ns_yoyo::FVertexBuffer& Buffer, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	Buffer.BlobPath = Session.WriteBlob(Buffer.RawData.GetData(), Buffer.RawData.Num());
+	BlobPaths.AddUnique(Buffer.BlobPath);
+	Buffer.RawData.Empty();
+}
+
+static void ShareBlob(ns_yoyo::FIndexBuffer& Buffer, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	// the blob holds the indices in the width of the file
+	if (Buffer.IndexWidth == sizeof(uint16))
+	{
+		TArray<uint16> ShortData;
+		ShortData.SetNumUninitialized(Buffer.BufferData.Num());
+		for (int32 i = 0; i < Buffer.BufferData.Num(); ++i)
+		{
+			ShortData[i] = (uint16)Buffer.BufferData[i];
+		}
+		Buffer.BlobPath = Session.WriteBlob(ShortData.GetData(), ShortData.Num() * sizeof(uint16));
+	}
+	else
+	{
+		Buffer.BlobPath = Session.WriteBlob(Buffer.BufferData.GetData(), Buffer.BufferData.Num() * sizeof(uint32));
+	}
+	BlobPaths.AddUnique(Buffer.BlobPath);
+	Buffer.BufferData.Empty();
+}
+
+static void ShareBlob(ns_yoyo::FSkinWeightBuffer& Buffer, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	Buffer.BlobPath = Session.WriteBlob(Buffer.RawData.GetData(), Buffer.RawData.Num());
+	BlobPaths.AddUnique(Buffer.BlobPath);
+	Buffer.RawData.Empty();
+}
+
+// identical mips of different textures are stored once
+static void ShareBlobs(ns_yoyo::FTextureResource& Resource, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	for (ns_yoyo::FTextureMip& Mip : Resource.Mips)
+	{
+		Mip.BlobPath = Session.WriteBlob(Mip.Data.GetData(), Mip.Data.Num());
+		BlobPaths.AddUnique(Mip.BlobPath);
+		Mip.Data.Empty();
+	}
+}
+
+// skeletons, animations and scenes keep their data
+template<typename TResource>
+static void ShareBlobs(TResource& Resource, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+}
+
+static void ShareBlobs(ns_yoyo::FStaticMeshResource& Resource, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	for (ns_yoyo::FVertexBuffer& VertexBuffer : Resource.VertexBuffers)
+	{
+		ShareBlob(VertexBuffer, Session, BlobPaths);
+	}
+	ShareBlob(Resource.IndexBuffer, Session, BlobPaths);
+}
+
+static void ShareBlobs(ns_yoyo::FSkeletalMeshResource& Resource, ns_yoyo::FExportSession& Session, TArray<FString>& BlobPaths)
+{
+	for (ns_yoyo::FVertexBuffer& VertexBuffer : Resource.VertexBuffers)
+	{
+		ShareBlob(VertexBuffer, Session, BlobPaths);
+	}
+	ShareBlob(Resource.IndexBuffer, Session, BlobPaths);
+	for (ns_yoyo::FSkinWeightBuffer& SkinWeightBuffer : Resource.SkinWeightBuffers)
+	{
+		ShareBlob(SkinWeightBuffer, Session, BlobPaths);
+	}
+}
+
+// md5 of the package the resource is built from, what the manifest compares
+static FString HashSource(const FAssetSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	return Manifest.HashSourceFile(Source.PackageFilename);
+}
+
+// md5 over the md5 of every package file, empty when one of them has no file to compare
+static FString HashPackages(const TArray<FString>& PackageFilenames, ns_yoyo::FExportManifest& Manifest)
+{
+	FMD5 Md5;
+	for (const FString& Filename : PackageFilenames)
+	{
+		const FString FileHash = Manifest.HashSourceFile(Filename);
+		if (FileHash.IsEmpty())
+		{
+			return FString();
+		}
+		Md5.Update((const uint8*)*FileHash, FileHash.Len() * sizeof(TCHAR));
+	}
+	FMD5Hash Hash;
+	Hash.Set(Md5);
+	return LexToString(Hash);
+}
+
+// the material table is exported with the mesh, an edit to a material or one of its parents exports it again
+template<typename TMeshSource>
+static FString HashMeshSource(const TMeshSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	TArray<FString> PackageFilenames = { Source.PackageFilename };
+	PackageFilenames.Append(Source.MaterialPackageFilenames);
+	return HashPackages(PackageFilenames, Manifest);
+}
+
+static FString HashSource(const FStaticMeshSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	return HashMeshSource(Source, Manifest);
+}
+
+static FString HashSource(const FSkeletalMeshSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	return HashMeshSource(Source, Manifest);
+}
+
+// baked matrices are relative to the skeleton's reference pose, a change to it bakes them again
+static FString HashSource(const FAnimSequenceSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	if (Source.BakedSpace == ns_yoyo::FAnimSequenceResource::EBakedSpace::None)
+	{
+		return HashSource(static_cast<const FAssetSource&>(Source), Manifest);
+	}
+	return HashPackages({ Source.PackageFilename, Source.SkeletonPackageFilename }, Manifest);
+}
+
+// a change to either package bakes the animation again, either one without a hash exports it every time
+static FString HashSource(const FVertexAnimationSource& Source, ns_yoyo::FExportManifest& Manifest)
+{
+	const FString MeshHash = HashSource(Source.Mesh->Source, Manifest);
+	const FString AnimHash = HashSource(Source.Anim, Manifest);
+	return MeshHash.IsEmpty() || AnimHash.IsEmpty() ? FString() : MeshHash + AnimHash;
+}
+
+// builds the resource and returns its write, nothing when the session or the manifest already has it
+template<typename TSource>
+TFunction<void()> ConvertSource(const TSource& Source, ns_yoyo::FExportSession& Session)
+{
+	ns_yoyo::FExportManifest& Manifest = Session.GetManifest();
+	FString SourceHash;
+	{
+		EXPORT_STAGE_SCOPE(Source.Record, Manifest);
+		SourceHash = HashSource(Source, Manifest);
+		// already written by this session, or up to date from an earlier one
+		if (!Session.ClaimResource(Source.Path, SourceHash)
+			|| (CVarExportIncremental.GetValueOnAnyThread() && Manifest.IsUpToDate(Source.Path, SourceHash)))
+		{
+			if (Source.Record)
+			{
+				Source.Record->bSkipped = true;
+			}
+			return nullptr;
+		}
+	}
+
+	typename TSource::FResource Resource;
+	BuildResource(Source, Resource);
+
+	return [Resource = MoveTemp(Resource), Path = Source.Path, PackageName = Source.PackageName, Record = Source.Record,
+		SourceHash, &Session]() mutable
+	{
+		const FString& OutPath = Session.GetOutPath();
+		// serialize to file
+		TArray<FString> BlobPaths;
+		{
+			EXPORT_STAGE_SCOPE(Record, Write);
+			if (CVarExportSharedBlobs.GetValueOnAnyThread())
+			{
+				ShareBlobs(Resource, Session, BlobPaths);
+			}
+			bool bOk = SerializeToFile(Resource, OutPath, GetSerializeOptions());
+			check(bOk);
+		}
+		if (Record)
+		{
+			Record->BytesWritten = IFileManager::Get().FileSize(*(OutPath + Path));
+		}
+
+		EXPORT_STAGE_SCOPE(Record, Manifest);
+		Session.GetManifest().Update(Path, PackageName, SourceHash, BlobPaths);
+	};
+}
+
+// rough peak of a resource and its intermediates while it converts, what AssetExporter.MemoryBudgetMB counts
+static int64 EstimateResourceBytes(const FStaticMeshSource& Source)
+{
+	int64 Bytes = 0;
+	for (const FStaticMeshLODResources* LODResource : Source.LODResources)
+	{
+		// the optimizer keeps a copy of the vertices and indices
+		Bytes += 2 * (int64)LODResource->GetNumVertices() * Source.VertexLayout.GetStride();
+		Bytes += 2 * (int64)LODResource->IndexBuffer.GetNumIndices() * sizeof(uint32);
+	}
+	return Bytes;
+}
+
+static int64 EstimateResourceBytes(const FSkeletalMeshSource& Source)
+{
+	int64 Bytes = 0;
+	for (const FSkeletalMeshLODRenderData* LODData : Source.LODRenderData)
+	{
+		const int64 NumVertices = LODData->GetNumVertices();
+		// up to 8 influences of a 16 bit bone index and a weight
+		Bytes += 2 * NumVertices * (Source.VertexLayout.GetStride() + 8 * 3);
+		Bytes += 2 * (int64)LODData->MultiSizeIndexContainer.GetIndexBuffer()->Num() * sizeof(uint32);
+	}
+	return Bytes;
+}
+
+static int64 EstimateResourceBytes(const FAnimSequenceSource& Source)
+{
+	const int64 NumFrames = Source.SampleRate > 0.f ? FMath::CeilToInt(Source.SequenceLength * Source.SampleRate) + 1 : Source.NumFrames;
+	// raw keys and their compressed copy
+	int64 Bytes = 2 * NumFrames * Source.TrackNames->Num() * (2 * sizeof(FVector) + sizeof(FQuat));
+	if (Source.BakedSpace != ns_yoyo::FAnimSequenceResource::EBakedSpace::None)
+	{
+		Bytes += NumFrames * Source.ReferenceSkel->GetRawBoneNum() * sizeof(ns_yoyo::FMatrix3x4);
+	}
+	return Bytes;
+}
+
+static int64 EstimateResourceBytes(const FSkeletonSource& Source)
+{
+	return 0;
+}
+
+static int64 EstimateResourceBytes(const FTextureSource& Source)
+{
+	int64 Bytes = 0;
+	for (const TArray<uint8>& Mip : Source.Mips)
+	{
+		Bytes += Mip.Num();
+	}
+	// the loaded mips and their transcoded copy
+	return 2 * Bytes;
+}
+
+static int64 EstimateResourceBytes(const FVertexAnimationSource& Source)
+{
+	const FSkeletalMeshLODRenderData* LODData = Source.Mesh->Source.LODRenderData[Source.Mesh->BuiltLODIndex];
+	const int64 NumFrames = Source.Anim.SampleRate > 0.f ? FMath::CeilToInt(Source.Anim.SequenceLength * Source.Anim.SampleRate) + 1 : Source.Anim.NumFrames;
+	// the shared mesh is counted by every job, any of them may build it
+	// a position and a normal texel of 4 halves per vertex and frame
+	return EstimateResourceBytes(Source.Mesh->Source) + EstimateResourceBytes(Source.Anim) + NumFrames * LODData->GetNumVertices() * 2 * 4 * sizeof(uint16);
+}
+
+static int64 EstimateSceneBytes(const ns_yoyo::FLevelSceneInfo& SceneInfo)
+{
+	int64 NumInstances = 0;
+	for (const ns_yoyo::FStaticMeshInstanceGroup& Group : SceneInfo.StaticMeshInstanceGroups)
+	{
+		NumInstances += Group.GetNumInstances();
+	}
+	// the instances and the BVH built over their bounds
+	return NumInstances * (sizeof(FQuat) + 2 * sizeof(FVector) + 2 * sizeof(ns_yoyo::FAABB));
+}
+
+template<typename TSource>
+static int32 AddExportJob(ns_yoyo::FExportJobGraph& Graph, TSource Source, ns_yoyo::FExportSession& Session)
+{
+	const int64 EstimatedBytes = EstimateResourceBytes(Source);
+	return Graph.AddJob([Source = MoveTemp(Source), &Session]() { return ConvertSource(Source, Session); }, EstimatedBytes);
+}
+
+// session opened by BeginExportSession, shared by every export into its output root until EndExportSession
+static TUniquePtr<ns_yoyo::FExportSession> ActiveExportSession;
+
+// exports into the open session of Path, or into one of its own saved right after
+static void ExportWithSession(const FString& Path, TFunctionRef<void(ns_yoyo::FExportSession&)> Export)
+{
+	if (ActiveExportSession && ActiveExportSession->GetOutPath() == Path)
+	{
+		Export(*ActiveExportSession);
+		return;
+	}
+	ns_yoyo::FExportSession Session(Path, UAssetExporterBPLibrary::GetExportSettingsHash());
+	Export(Session);
+	bool bOk = Session.GetManifest().Save();
+	check(bOk);
+}
+
+// runs the graph on AssetExporter.NumThreads threads within AssetExporter.MemoryBudgetMB
+static void RunExportGraph(ns_yoyo::FExportJobGraph& Graph)
+{
+	int32 NumThreads = CVarExportNumThreads.GetValueOnGameThread();
+	if (NumThreads <= 0)
+	{
+		NumThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	}
+	NumThreads = FMath::Min(NumThreads, Graph.NumJobs());
+	const int64 MemoryBudget = (int64)CVarExportMemoryBudgetMB.GetValueOnGameThread() * 1024 * 1024;
+	Graph.Run(NumThreads, MemoryBudget);
+	UE_LOG(LogTemp, Log, TEXT("Exported %d jobs on %d threads, at most %.1f MB in flight"),
+		Graph.NumJobs(), NumThreads, Graph.GetPeakBytesInFlight() / (1024.0 * 1024.0));
+}
+
+// AssetExporter.Textures, the textures of a mesh's materials are exported with it
+static void AddMaterialTextures(TSet<UTexture2D*>& Textures, const TSet<UTexture2D*>& MaterialTextures)
+{
+	if (CVarExportTextures.GetValueOnGameThread())
+	{
+		Textures.Append(MaterialTextures);
+	}
+}
+
+// a texture is gathered once however many materials share it, the session skips those already written
+static void AddTextureJobs(ns_yoyo::FExportJobGraph& Graph, const TSet<UTexture2D*>& Textures, ns_yoyo::FExportSession& Session)
+{
+	for (UTexture2D* Texture : Textures)
+	{
+		if (!CanExportTexture(Texture))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s has no platform data in a format that can be exported, skipped"), *Texture->GetPathName());
+			continue;
+		}
+		AddExportJob(Graph, GatherTexture(Texture, Session.GetReport()), Session);
+	}
 }
-#if 1
-template<ns_yoyo::EResourceType ResourceType>
-FString GetAssetPath(UObject* Asset)
+
+// meshes and animations reference their skeleton by path, they are written after it
+static void AddSkeletonPrerequisites(ns_yoyo::FExportJobGraph& Graph, const TArray<TPair<int32, USkeleton*>>& Dependents,
+	const TMap<USkeleton*, int32>& SkeletonJobs)
 {
-	auto package_path = Asset->GetPackage()->GetPathName();
-	package_path.ReplaceInline(TEXT("/Game"), TEXT(""));
-	switch (ResourceType)
+	for (const TPair<int32, USkeleton*>& Dependent : Dependents)
 	{
-	case ns_yoyo::EResourceType::Level:
-		package_path += TEXT(".scene");
-		break;
-	case ns_yoyo::EResourceType::StaticMesh:
-		package_path += TEXT(".mesh");
-		break;
-	case ns_yoyo::EResourceType::SkeletalMesh:
-		package_path += TEXT(".skelmesh");
-		break;
-	case ns_yoyo::EResourceType::AnimSequence:
-		package_path += TEXT(".anim");
-		break;
-	case ns_yoyo::EResourceType::Skeleton:
-		package_path += TEXT(".skel");
-		break;
-	case ns_yoyo::EResourceType::Max:
-	default:
-		check(false);
-		break;
+		if (const int32* SkeletonJob = SkeletonJobs.Find(Dependent.Value))
+		{
+			Graph.AddPrerequisite(Dependent.Key, *SkeletonJob);
+		}
 	}
-	return package_path;
 }
-#else
-FString GetAssetPath(UObject* Asset)
+
+// adds the component, or every instance of an instanced component, to the instance group of its mesh
+static void GatherStaticMeshInstances(UStaticMeshComponent* Component, const FTransform& LevelTransform,
+	ns_yoyo::FLevelSceneInfo& SceneInfo, TMap<UStaticMesh*, int32>& GroupIndices)
 {
-	auto package_path = Asset->GetPackage()->GetPathName();
-	package_path.ReplaceInline(TEXT("/Game"), TEXT(""));
-	return package_path;
+	UStaticMesh* StaticMesh = Component->GetStaticMesh();
+	if (!StaticMesh)
+	{
+		return;
+	}
+	UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component);
+	if (InstancedComponent && InstancedComponent->GetInstanceCount() == 0)
+	{
+		return;
+	}
+
+	int32* GroupIndex = GroupIndices.Find(StaticMesh);
+	if (!GroupIndex)
+	{
+		ns_yoyo::FStaticMeshInstanceGroup& NewGroup = SceneInfo.StaticMeshInstanceGroups.AddDefaulted_GetRef();
+		NewGroup.ResourceIndex = SceneInfo.StaticMeshResourcePaths.Add(GetAssetPath<ns_yoyo::EResourceType::StaticMesh>(StaticMesh));
+		GroupIndex = &GroupIndices.Add(StaticMesh, SceneInfo.StaticMeshInstanceGroups.Num() - 1);
+	}
+	ns_yoyo::FStaticMeshInstanceGroup& Group = SceneInfo.StaticMeshInstanceGroups[*GroupIndex];
+	const FBox LocalBounds = StaticMesh->GetBoundingBox();
+
+	if (InstancedComponent)
+	{
+		// ISM, HISM and foliage, the instances are relative to the component
+		const int32 NumInstances = InstancedComponent->GetInstanceCount();
+		Group.Rotations.Reserve(Group.Rotations.Num() + NumInstances);
+		Group.Translations.Reserve(Group.Translations.Num() + NumInstances);
+		Group.Scales.Reserve(Group.Scales.Num() + NumInstances);
+		Group.Bounds.Reserve(Group.Bounds.Num() + NumInstances);
+		for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+		{
+			FTransform InstanceTransform;
+			InstancedComponent->GetInstanceTransform(InstanceIndex, InstanceTransform, true);
+			Group.AddInstance(InstanceTransform * LevelTransform, LocalBounds);
+		}
+	}
+	else
+	{
+		Group.AddInstance(Component->GetComponentTransform() * LevelTransform, LocalBounds);
+	}
 }
-#endif
 
 UAssetExporterBPLibrary::UAssetExporterBPLibrary(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
@@ -166,152 +1649,49 @@ void UAssetExporterBPLibrary::ExportDirectionalLight(ADirectionalLight* UELight,
 
 void UAssetExporterBPLibrary::ExportSkeletalMesh(USkeletalMesh* SkelMesh, const FString& Path)
 {
-	ns_yoyo::FSkeletalMeshResource yySkeletalMeshResource;
-
-	check(SkelMesh);
-	FSkeletalMeshRenderData* RenderData = SkelMesh->GetResourceForRendering();
-	check(RenderData && RenderData->LODRenderData.Num() > 0);
-	FSkeletalMeshLODRenderData& LOD0 = RenderData->LODRenderData[0];
-
-	// fill the path
-	yySkeletalMeshResource.Path = GetAssetPath<ns_yoyo::EResourceType::SkeletalMesh>(SkelMesh);
-	yySkeletalMeshResource.SkelAssetPath = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(SkelMesh->Skeleton);
-
-	// fill the sections
-	int32 NumTriangles = 0;
-	for (FSkelMeshRenderSection& ueSection : LOD0.RenderSections)
-	{
-		ns_yoyo::FSkelMeshRenderSection yySkelMeshRenderSection;
-		yySkelMeshRenderSection.BaseIndex = ueSection.BaseIndex;
-		yySkelMeshRenderSection.BaseVertexIndex = ueSection.BaseVertexIndex;
-		yySkelMeshRenderSection.bCastShadow = ueSection.bCastShadow;
-		yySkelMeshRenderSection.MaterialIndex = ueSection.MaterialIndex;
-		yySkelMeshRenderSection.MaxBoneInfluences = ueSection.MaxBoneInfluences;
-		yySkelMeshRenderSection.NumTriangles = ueSection.NumTriangles;
-		yySkelMeshRenderSection.NumVertices = ueSection.NumVertices;
-		yySkelMeshRenderSection.BoneMap.Reserve(ueSection.BoneMap.Num());
-		for (auto& BoneIndex : ueSection.BoneMap)
-		{
-			yySkelMeshRenderSection.BoneMap.Add(BoneIndex);
-		}
-		yySkeletalMeshResource.RenderSections.Add(yySkelMeshRenderSection);
-		NumTriangles += ueSection.NumTriangles;
-	}
-
-	// vertex buffer
-	ns_yoyo::ExportVertexBuffer(yySkeletalMeshResource.VertexBuffer, LOD0.StaticVertexBuffers);
-
-	// index buffer
-	ns_yoyo::ExportMultiSizeIndexContainer(yySkeletalMeshResource.IndexBuffer, LOD0.MultiSizeIndexContainer);
-	check(yySkeletalMeshResource.IndexBuffer.NumIndices == NumTriangles * 3);
-
-	// skin weight buffer
-	FSkinWeightVertexBuffer* WeightVertexBuffer = LOD0.GetSkinWeightVertexBuffer();
-	TArray<FSkinWeightInfo> SkinWeightInfos;
-	WeightVertexBuffer->GetSkinWeights(SkinWeightInfos);
-	for (auto& WeightInfo : SkinWeightInfos)
-	{
-		ns_yoyo::FSkinWeightInfo yyInfo;
-		FMemory::Memcpy(yyInfo.InfluenceBones, WeightInfo.InfluenceBones, sizeof(FBoneIndexType) * 4);
-		FMemory::Memcpy(yyInfo.InfluenceWeights, WeightInfo.InfluenceWeights, sizeof(uint8) * 4);
-		yySkeletalMeshResource.SkinWeightBuffer.SkinWeightInfos.Emplace(yyInfo);
-	}
-
-	// serialize to file
-	bool bOk = SerializeToFile(yySkeletalMeshResource, Path);
-	check(bOk);
+	ExportWithSession(Path, [SkelMesh](ns_yoyo::FExportSession& Session) { ExportAssets({ SkelMesh }, Session); });
 }
 
 void UAssetExporterBPLibrary::ExportAnimSequence(UAnimSequence* AnimSequence, const FString& Path)
 {
-	check(AnimSequence);
-	const TArray<FRawAnimSequenceTrack>& BoneTracks = AnimSequence->GetRawAnimationData();
-	int32 NumRawFrames = AnimSequence->GetRawNumberOfFrames();
-	int32 NumFrames = AnimSequence->GetNumberOfFrames();
-	//const TArray<FTrackToSkeletonMap>& TrackBoneIndices = AnimSequence->GetRawTrackToSkeletonMapTable();
-
-	ns_yoyo::FAnimSequenceResource yyAnimSequence;
-	yyAnimSequence.Path = GetAssetPath<ns_yoyo::EResourceType::AnimSequence>(AnimSequence);
-	yyAnimSequence.NumFrames = NumRawFrames;
-	yyAnimSequence.RawAnimationData.AddZeroed(BoneTracks.Num());
-	for (int32 i = 0; i < BoneTracks.Num(); ++i)
-	{
-		yyAnimSequence.RawAnimationData[i].PosKeys = BoneTracks[i].PosKeys;
-		yyAnimSequence.RawAnimationData[i].RotKeys = BoneTracks[i].RotKeys;
-		yyAnimSequence.RawAnimationData[i].ScaleKeys = BoneTracks[i].ScaleKeys;
-	}
-	USkeleton* Skeleton = AnimSequence->GetSkeleton();
-	check(Skeleton);
-	yyAnimSequence.SkelAssetPath = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(Skeleton);
-
-	bool bOk = SerializeToFile(yyAnimSequence, Path);
-	check(bOk);
+	ExportWithSession(Path, [AnimSequence](ns_yoyo::FExportSession& Session) { ExportAssets({ AnimSequence }, Session); });
 }
 
 void UAssetExporterBPLibrary::ExportSkeleton(USkeleton* Skeleton, const FString& Path)
 {
-	check(Skeleton);
-	const FReferenceSkeleton& ReferenceSkel = Skeleton->GetReferenceSkeleton();
-	const TArray<FMeshBoneInfo>& BoneInfo = ReferenceSkel.GetRawRefBoneInfo();
-	const TArray<FTransform>& BonePose = ReferenceSkel.GetRawRefBonePose();
+	ExportWithSession(Path, [Skeleton](ns_yoyo::FExportSession& Session) { ExportAssets({ Skeleton }, Session); });
+}
 
-	ns_yoyo::FSkeleton yySkeleton;
-	yySkeleton.Path = GetAssetPath<ns_yoyo::EResourceType::Skeleton>(Skeleton);
-	yySkeleton.BoneInfos.AddZeroed(BoneInfo.Num());
-	for (int32 i = 0; i < BoneInfo.Num(); ++i)
-	{
-		yySkeleton.BoneInfos[i].Name = BoneInfo[i].ExportName;
-		yySkeleton.BoneInfos[i].ParentIndex = BoneInfo[i].ParentIndex;
-	}
-	yySkeleton.BonePoses.AddZeroed(BonePose.Num());
-	for (int32 i = 0; i < BonePose.Num(); ++i)
+void UAssetExporterBPLibrary::ExportVertexAnimations(USkeletalMesh* SkelMesh, const TArray<UAnimSequence*>& AnimSequences, const FString& Path)
+{
+	ExportWithSession(Path, [SkelMesh, &AnimSequences](ns_yoyo::FExportSession& Session)
 	{
-		//yySkeleton.BonePoses[i].Rot = ns_yoyo::Quat2Vec4(BonePose[i].Rotator().Quaternion());
-		yySkeleton.BonePoses[i].Rot = BonePose[i].Rotator().Quaternion();
-		yySkeleton.BonePoses[i].Trans = BonePose[i].GetLocation();
-		yySkeleton.BonePoses[i].Scale = BonePose[i].GetScale3D();
-	}
+		// the deltas apply to the vertices of the exported mesh
+		ExportAssets({ SkelMesh }, Session);
+		ns_yoyo::FExportJobGraph Graph;
+		const TSharedRef<FVertexAnimationMesh, ESPMode::ThreadSafe> Mesh = GatherVertexAnimationMesh(SkelMesh);
+		TSet<UAnimSequence*> GatheredAnimSequences;
+		for (UAnimSequence* AnimSequence : AnimSequences)
+		{
+			bool bAlreadyGathered = false;
+			GatheredAnimSequences.Add(AnimSequence, &bAlreadyGathered);
+			if (!bAlreadyGathered)
+			{
+				AddExportJob(Graph, GatherVertexAnimation(Mesh, SkelMesh, AnimSequence, Session.GetReport()), Session);
+			}
+		}
+		RunExportGraph(Graph);
+	});
+}
 
-	bool bOk = SerializeToFile(yySkeleton, Path);
-	check(bOk);
+void UAssetExporterBPLibrary::ExportTexture(UTexture2D* Texture, const FString& Path)
+{
+	ExportWithSession(Path, [Texture](ns_yoyo::FExportSession& Session) { ExportAssets({ Texture }, Session); });
 }
 
 void UAssetExporterBPLibrary::ExportStaticMesh(UStaticMesh* Mesh, const FString& Path)
 {
-	// check and get the lod0 resource
-	check(Mesh && Mesh->RenderData && Mesh->RenderData->LODResources.Num() > 0);
-	FStaticMeshLODResources& LODResource = Mesh->RenderData->LODResources[0];
-	const int32 NumVerts = LODResource.GetNumVertices();
-	const int32 NumTris = LODResource.GetNumTriangles();
-
-	ns_yoyo::FStaticMeshResource yyMeshResource;
-
-	// build resource path
-	yyMeshResource.Path = GetAssetPath<ns_yoyo::EResourceType::StaticMesh>(Mesh);
-
-	// sections
-	for (auto& ueSection : LODResource.Sections)
-	{
-		ns_yoyo::FStaticMeshSection yySection;
-		yySection.FirstIndex = ueSection.FirstIndex;
-		yySection.MaterialIndex = ueSection.MaterialIndex;
-		yySection.MaxVertexIndex = ueSection.MaxVertexIndex;
-		yySection.MinVertexIndex = ueSection.MinVertexIndex;
-		yySection.NumTriangles = ueSection.NumTriangles;
-		yySection.bCastShadow = ueSection.bCastShadow;
-		yyMeshResource.Sections.Add(yySection);
-	}
-	
-	// vertex buffer
-	ns_yoyo::ExportVertexBuffer(yyMeshResource.VertexBuffer, LODResource.VertexBuffers);
-
-	// index buffer
-	ns_yoyo::ExportStaticIndexBuffer(yyMeshResource.IndexBuffer, LODResource.IndexBuffer);
-	check(yyMeshResource.IndexBuffer.NumIndices == NumTris * 3);
-
-	// serialize to file
-	bool bOk = SerializeToFile(yyMeshResource, Path);
-	check(bOk);
+	ExportWithSession(Path, [Mesh](ns_yoyo::FExportSession& Session) { ExportAssets({ Mesh }, Session); });
 }
 
 void UAssetExporterBPLibrary::ExportAsset(UObject* Asset, const FString& Path)
@@ -336,124 +1716,443 @@ void UAssetExporterBPLibrary::ExportAsset(UObject* Asset, const FString& Path)
 	{
 		return ExportSkeleton(Cast<USkeleton>(Asset), Path);
 	}
+	if (Asset->IsA(UTexture2D::StaticClass()))
+	{
+		return ExportTexture(Cast<UTexture2D>(Asset), Path);
+	}
+}
+
+void UAssetExporterBPLibrary::ExportAssets(const TArray<UObject*>& Assets, ns_yoyo::FExportSession& Session)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AssetExporter_ExportAssets);
+	ns_yoyo::FExportReport* Report = Session.GetReport();
+	ns_yoyo::FExportJobGraph Graph;
+	TArray<TPair<int32, USkeleton*>> SkeletonDependents;
+	// assets listed twice and skeletons the meshes and animations depend on are gathered once,
+	// the session skips those an earlier call already wrote
+	TSet<UObject*> GatheredAssets;
+	TSet<USkeleton*> Skeletons;
+	TSet<UTexture2D*> Textures;
+	for (UObject* Asset : Assets)
+	{
+		bool bAlreadyGathered = false;
+		GatheredAssets.Add(Asset, &bAlreadyGathered);
+		if (bAlreadyGathered)
+		{
+			continue;
+		}
+		if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Asset))
+		{
+			FStaticMeshSource Source = GatherStaticMesh(StaticMesh, Report);
+			AddMaterialTextures(Textures, Source.Textures);
+			AddExportJob(Graph, MoveTemp(Source), Session);
+		}
+		else if (USkeletalMesh* SkelMesh = Cast<USkeletalMesh>(Asset))
+		{
+			FSkeletalMeshSource Source = GatherSkeletalMesh(SkelMesh, Report);
+			AddMaterialTextures(Textures, Source.Textures);
+			const int32 Job = AddExportJob(Graph, MoveTemp(Source), Session);
+			if (SkelMesh->Skeleton)
+			{
+				Skeletons.Add(SkelMesh->Skeleton);
+				SkeletonDependents.Emplace(Job, SkelMesh->Skeleton);
+			}
+		}
+		else if (UAnimSequence* AnimSeq = Cast<UAnimSequence>(Asset))
+		{
+			const int32 Job = AddExportJob(Graph, GatherAnimSequence(AnimSeq, Report), Session);
+			Skeletons.Add(AnimSeq->GetSkeleton());
+			SkeletonDependents.Emplace(Job, AnimSeq->GetSkeleton());
+		}
+		else if (USkeleton* Skeleton = Cast<USkeleton>(Asset))
+		{
+			Skeletons.Add(Skeleton);
+		}
+		else if (UTexture2D* Texture = Cast<UTexture2D>(Asset))
+		{
+			Textures.Add(Texture);
+		}
+		else if (UWorld* World = Cast<UWorld>(Asset))
+		{
+			// maps gather their actors on the game thread and run their own jobs
+			ExportMap(World, Session);
+		}
+	}
+	TMap<USkeleton*, int32> SkeletonJobs;
+	for (USkeleton* Skeleton : Skeletons)
+	{
+		SkeletonJobs.Add(Skeleton, AddExportJob(Graph, GatherSkeleton(Skeleton, Report), Session));
+	}
+	AddSkeletonPrerequisites(Graph, SkeletonDependents, SkeletonJobs);
+	AddTextureJobs(Graph, Textures, Session);
+	RunExportGraph(Graph);
+}
+
+// sweeps the files of deleted assets, saves the manifest and the report of a session that is done
+static void FinishExportSession(ns_yoyo::FExportSession& Session)
+{
+	int32 NumRemoved = Session.GetManifest().RemoveStaleEntries();
+	UE_LOG(LogTemp, Log, TEXT("Removed %d exported files of deleted assets"), NumRemoved);
+	bool bOk = Session.GetManifest().Save();
+	check(bOk);
+	if (Session.GetReport())
+	{
+		UAssetExporterBPLibrary::SaveExportReport(*Session.GetReport(), Session.GetOutPath() / TEXT("AssetExporter.report"));
+	}
+	Session.LogStats();
 }
 
 void UAssetExporterBPLibrary::ExportMap(UWorld* World, const FString& Path)
 {
-	UE_LOG(LogTemp, Log, TEXT("RootPath = "), *Path);
+	if (ActiveExportSession && ActiveExportSession->GetOutPath() == Path)
+	{
+		// the session sweeps the manifest and saves the report when it ends
+		ExportMap(World, *ActiveExportSession);
+		return;
+	}
+	ns_yoyo::FExportSession Session(Path, GetExportSettingsHash(), TEXT("AssetExporter"), IsExportReportEnabled());
+	ExportMap(World, Session);
+	FinishExportSession(Session);
+}
+
+void UAssetExporterBPLibrary::BeginExportSession(const FString& Path)
+{
+	if (ActiveExportSession)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Ending the export session of %s to begin one for %s"),
+			*ActiveExportSession->GetOutPath(), *Path);
+		EndExportSession();
+	}
+	ActiveExportSession = MakeUnique<ns_yoyo::FExportSession>(Path, GetExportSettingsHash(), TEXT("AssetExporter"),
+		IsExportReportEnabled());
+}
+
+void UAssetExporterBPLibrary::EndExportSession()
+{
+	if (!ActiveExportSession)
+	{
+		return;
+	}
+	FinishExportSession(*ActiveExportSession);
+	ActiveExportSession.Reset();
+}
+
+bool UAssetExporterBPLibrary::IsExportReportEnabled()
+{
+	return CVarExportReport.GetValueOnGameThread() != 0;
+}
+
+void UAssetExporterBPLibrary::SaveExportReport(const ns_yoyo::FExportReport& Report, const FString& BasePath)
+{
+	if (Report.Save(BasePath, CVarExportReportSlowest.GetValueOnGameThread()))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Export report saved to %s.json/.csv"), *BasePath);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to save the export report to %s"), *BasePath);
+	}
+}
+
+void UAssetExporterBPLibrary::ExportMap(UWorld* World, ns_yoyo::FExportSession& Session)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AssetExporter_ExportMap);
+	const FString& Path = Session.GetOutPath();
+	ns_yoyo::FExportManifest& Manifest = Session.GetManifest();
+	ns_yoyo::FExportReport* Report = Session.GetReport();
+	UE_LOG(LogTemp, Log, TEXT("Exporting %s to %s"), *World->GetPathName(), *Path);
 
 	ns_yoyo::FLevelSceneInfo yySceneInfo;
 
 	TSet<UStaticMesh*> ExportedStaticMeshes;
+	TMap<UStaticMesh*, int32> StaticMeshGroupIndices;
 	TSet<USkeletalMesh*> ExportedSkelMeshes;
 	TSet<UAnimSequence*> ExportedAnimSequences;
 	TSet<USkeleton*> ExportedSkeletons;
 
 	ULevel* Level = World->PersistentLevel;
-	for (AActor* Actor : Level->Actors)
+	ns_yoyo::FAssetExportRecord* LevelRecord = Report
+		? Report->AddAsset(GetAssetPath<ns_yoyo::EResourceType::Level>(Level), ns_yoyo::EResourceType::Level) : nullptr;
+	TOptional<ns_yoyo::FExportStageScope> GatherScope;
+	GatherScope.Emplace(LevelRecord, ns_yoyo::EExportStage::Gather);
+
+	// the persistent level first and every sub-level, levels in the world are already placed in it,
+	// streaming levels that aren't are placed by their level transform, loaded on their own if need be
+	TArray<TPair<ULevel*, FTransform>> Levels;
+	Levels.Emplace(Level, FTransform::Identity);
+	for (ULevel* SubLevel : World->GetLevels())
+	{
+		if (SubLevel != Level)
+		{
+			Levels.Emplace(SubLevel, FTransform::Identity);
+		}
+	}
+	// released once the export is done, packages that were loaded before are left alone
+	TArray<UPackage*> LoadedLevelPackages;
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
 	{
-		// static mesh
-		if (Actor->IsA(AStaticMeshActor::StaticClass()))
+		if (!StreamingLevel)
 		{
-			TArray<UStaticMeshComponent*> StaticMeshComponents;
-			Actor->GetComponents(StaticMeshComponents);
-			// export every static mesh component
-			for (auto Component : StaticMeshComponents)
+			continue;
+		}
+		// loaded but hidden levels aren't in the world yet, nor moved by their transform
+		if (ULevel* LoadedLevel = StreamingLevel->GetLoadedLevel())
+		{
+			if (!World->GetLevels().Contains(LoadedLevel))
 			{
-				UStaticMesh* StaticMesh =
-					Cast<UStaticMeshComponent>(Component)->GetStaticMesh();
-				if (StaticMesh)
-				{
-					// cache the mesh for exporting
-					ExportedStaticMeshes.Add(StaticMesh);
-
-					// build static mesh scene info
-					ns_yoyo::FStaticMeshSceneInfo yyStaticMeshSceneInfo;
-					yyStaticMeshSceneInfo.ResourcePath = 
-						GetAssetPath<ns_yoyo::EResourceType::StaticMesh>(StaticMesh);
-					yyStaticMeshSceneInfo.Transform = ns_yoyo::GetTransform(Component);
-					yySceneInfo.StaticMesheSceneInfos.Emplace(yyStaticMeshSceneInfo);
-				}
+				Levels.Emplace(LoadedLevel, StreamingLevel->LevelTransform);
 			}
 			continue;
 		}
-		if (Actor->IsA(ASkeletalMeshActor::StaticClass()) ||
-			Actor->IsA(ACharacter::StaticClass()))
+		const FString LevelPackageName = StreamingLevel->GetWorldAssetPackageName();
+		const bool bWasLoaded = FindPackage(nullptr, *LevelPackageName) != nullptr;
+		UPackage* LevelPackage = LoadPackage(nullptr, *LevelPackageName, LOAD_None);
+		UWorld* LevelWorld = LevelPackage ? UWorld::FindWorldInPackage(LevelPackage) : nullptr;
+		if (LevelPackage && !bWasLoaded)
+		{
+			LoadedLevelPackages.Add(LevelPackage);
+		}
+		if (!LevelWorld || !LevelWorld->PersistentLevel)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Failed to load streaming level %s"), *LevelPackageName);
+			continue;
+		}
+		Levels.Emplace(LevelWorld->PersistentLevel, StreamingLevel->LevelTransform);
+	}
+
+	// the persistent level's camera and light win over the sub-levels', otherwise the first level having one
+	ULevel* CameraLevel = nullptr;
+	ULevel* LightLevel = nullptr;
+	for (const TPair<ULevel*, FTransform>& LevelToGather : Levels)
+	{
+		ULevel* GatherLevel = LevelToGather.Key;
+		const FTransform& LevelTransform = LevelToGather.Value;
+		for (AActor* Actor : GatherLevel->Actors)
 		{
-			TArray<USkeletalMeshComponent*> SkelMeshComponents;
-			Actor->GetComponents(SkelMeshComponents);
-			for (auto Component : SkelMeshComponents)
+			if (!Actor)
+			{
+				continue;
+			}
+			// the components of levels loaded above were never registered, their world transforms
+			// are still to compute from the relative ones. nothing to do for registered components
+			TInlineComponentArray<USceneComponent*> SceneComponents(Actor);
+			for (USceneComponent* SceneComponent : SceneComponents)
+			{
+				SceneComponent->ConditionalUpdateComponentToWorld();
+			}
+			// static mesh
+			if (Actor->IsA(AStaticMeshActor::StaticClass()))
 			{
-				USkeletalMesh* SkelMesh = Component->SkeletalMesh;
-				if (SkelMesh)
+				TArray<UStaticMeshComponent*> StaticMeshComponents;
+				Actor->GetComponents(StaticMeshComponents);
+				// export every static mesh component
+				for (auto Component : StaticMeshComponents)
 				{
-					ExportedSkelMeshes.Add(SkelMesh);
-					// build skeletal mesh scene info
-					ns_yoyo::FSkeletalMeshSceneInfo yySkelMeshSceneInfo;
-					yySkelMeshSceneInfo.ResourcePath =
-						GetAssetPath<ns_yoyo::EResourceType::SkeletalMesh>(SkelMesh);
-					yySkelMeshSceneInfo.Transform = ns_yoyo::GetTransform(Component);
-					yySceneInfo.SkelMeshSceneInfos.Emplace(yySkelMeshSceneInfo);
+					GatherStaticMeshInstances(Component, LevelTransform, yySceneInfo, StaticMeshGroupIndices);
 				}
-				if (EAnimationMode::AnimationSingleNode == Component->GetAnimationMode())
+				continue;
+			}
+			if (Actor->IsA(ASkeletalMeshActor::StaticClass()) ||
+				Actor->IsA(ACharacter::StaticClass()))
+			{
+				TArray<USkeletalMeshComponent*> SkelMeshComponents;
+				Actor->GetComponents(SkelMeshComponents);
+				for (auto Component : SkelMeshComponents)
 				{
-					UAnimSequence* AnimSequence = Cast<UAnimSequence>(Component->AnimationData.AnimToPlay);
-					if (AnimSequence)
+					USkeletalMesh* SkelMesh = Component->SkeletalMesh;
+					if (SkelMesh)
+					{
+						ExportedSkelMeshes.Add(SkelMesh);
+						if (SkelMesh->Skeleton)
+						{
+							ExportedSkeletons.Add(SkelMesh->Skeleton);
+						}
+						// build skeletal mesh scene info
+						ns_yoyo::FSkeletalMeshSceneInfo yySkelMeshSceneInfo;
+						yySkelMeshSceneInfo.ResourcePath =
+							GetAssetPath<ns_yoyo::EResourceType::SkeletalMesh>(SkelMesh);
+						yySkelMeshSceneInfo.Transform = ns_yoyo::GetTransform(Component, LevelTransform);
+						yySceneInfo.SkelMeshSceneInfos.Emplace(yySkelMeshSceneInfo);
+					}
+					if (EAnimationMode::AnimationSingleNode == Component->GetAnimationMode())
 					{
-						ExportedAnimSequences.Add(AnimSequence);
-						USkeleton* Skeleton = AnimSequence->GetSkeleton();
-						check(Skeleton);
-						ExportedSkeletons.Add(Skeleton);
+						UAnimSequence* AnimSequence = Cast<UAnimSequence>(Component->AnimationData.AnimToPlay);
+						if (AnimSequence)
+						{
+							ExportedAnimSequences.Add(AnimSequence);
+							USkeleton* Skeleton = AnimSequence->GetSkeleton();
+							check(Skeleton);
+							ExportedSkeletons.Add(Skeleton);
+						}
 					}
 				}
+				continue;
+			}
+			if (Actor->IsA(ACameraActor::StaticClass()))
+			{
+				if (!CameraLevel || CameraLevel == GatherLevel)
+				{
+					ExportCamera(Cast<ACameraActor>(Actor), yySceneInfo);
+					CameraLevel = GatherLevel;
+				}
+				continue;
+			}
+			if (Actor->IsA(ADirectionalLight::StaticClass()))
+			{
+				if (!LightLevel || LightLevel == GatherLevel)
+				{
+					ExportDirectionalLight(Cast<ADirectionalLight>(Actor), yySceneInfo);
+					LightLevel = GatherLevel;
+				}
+				continue;
+			}
+			// instanced meshes of any other actor, foliage included
+			TArray<UInstancedStaticMeshComponent*> InstancedComponents;
+			Actor->GetComponents(InstancedComponents);
+			for (auto Component : InstancedComponents)
+			{
+				GatherStaticMeshInstances(Component, LevelTransform, yySceneInfo, StaticMeshGroupIndices);
 			}
-			continue;
-		}
-		if (Actor->IsA(ACameraActor::StaticClass()))
-		{
-			ExportCamera(Cast<ACameraActor>(Actor), yySceneInfo);
-			continue;
-		}
-		if (Actor->IsA(ADirectionalLight::StaticClass()))
-		{
-			ExportDirectionalLight(Cast<ADirectionalLight>(Actor), yySceneInfo);
-			continue;
 		}
 	}
+	GatherScope.Reset();
+
+	// cache the meshes for exporting
+	for (const TPair<UStaticMesh*, int32>& GroupIndex : StaticMeshGroupIndices)
+	{
+		ExportedStaticMeshes.Add(GroupIndex.Key);
+	}
+
+	// gather everything on the game thread, then convert and write in parallel
+	ns_yoyo::FExportJobGraph Graph;
+
+	// export skeletons
+	TMap<USkeleton*, int32> SkeletonJobs;
+	for (USkeleton* Skeleton : ExportedSkeletons)
+	{
+		SkeletonJobs.Add(Skeleton, AddExportJob(Graph, GatherSkeleton(Skeleton, Report), Session));
+	}
 
 	// export static meshes
+	TSet<UTexture2D*> Textures;
 	for (UStaticMesh* StaticMesh : ExportedStaticMeshes)
 	{
-		// export static mesh asset
-		ExportStaticMesh(StaticMesh, Path);
+		FStaticMeshSource Source = GatherStaticMesh(StaticMesh, Report);
+		AddMaterialTextures(Textures, Source.Textures);
+		AddExportJob(Graph, MoveTemp(Source), Session);
 	}
 
 	// export skeletal meshes
+	TArray<TPair<int32, USkeleton*>> SkeletonDependents;
 	for (USkeletalMesh* SkelMesh : ExportedSkelMeshes)
 	{
-		ExportSkeletalMesh(SkelMesh, Path);
+		FSkeletalMeshSource Source = GatherSkeletalMesh(SkelMesh, Report);
+		AddMaterialTextures(Textures, Source.Textures);
+		SkeletonDependents.Emplace(AddExportJob(Graph, MoveTemp(Source), Session), SkelMesh->Skeleton);
 	}
 
+	// export the textures of their materials
+	AddTextureJobs(Graph, Textures, Session);
+
 	// export animation sequences
 	for (UAnimSequence* AnimSeq : ExportedAnimSequences)
 	{
-		ExportAnimSequence(AnimSeq, Path);
+		SkeletonDependents.Emplace(AddExportJob(Graph, GatherAnimSequence(AnimSeq, Report), Session), AnimSeq->GetSkeleton());
 	}
+	AddSkeletonPrerequisites(Graph, SkeletonDependents, SkeletonJobs);
 
-	// export skeletons
-	for (USkeleton* Skeleton : ExportedSkeletons)
+	// the scene is always rewritten, it is only recorded so the sweep can find it
+	FAssetSource LevelSource;
+	GatherPackage(Level, LevelSource);
+	const FString LevelSourceHash = Manifest.HashSourceFile(LevelSource.PackageFilename);
+	const FString LevelPath = GetAssetPath<ns_yoyo::EResourceType::Level>(Level);
+
+	const float CellSize = CVarExportSceneCellSize.GetValueOnGameThread();
+	const ns_yoyo::ESceneEncoding SceneEncoding = (ns_yoyo::ESceneEncoding)FMath::Clamp(
+		CVarExportSceneEncoding.GetValueOnGameThread(), 0, (int32)ns_yoyo::ESceneEncoding::Max - 1);
+	TArray<ns_yoyo::FSceneCellChunk> CellChunks;
+	// every file the level exports into, the cells of another cell size are swept
+	TSet<FString> LevelPaths = { LevelPath };
+	if (CellSize > 0.f)
+	{
+		// every cell is a scene of its own, the level's scene keeps only the index
+		{
+			EXPORT_STAGE_SCOPE(LevelRecord, Gather);
+			ns_yoyo::SplitSceneIntoCells(yySceneInfo, CellSize, CellChunks);
+			yySceneInfo.StaticMeshInstanceGroups.Empty();
+			yySceneInfo.CellSize = CellSize;
+		}
+		const FString CellRoot = FPaths::GetBaseFilename(LevelPath, false);
+		for (ns_yoyo::FSceneCellChunk& Chunk : CellChunks)
+		{
+			Chunk.Cell.Path = CellRoot / FString::Printf(TEXT("Cell_%d_%d.scene"), Chunk.Cell.Coord.X, Chunk.Cell.Coord.Y);
+			LevelPaths.Add(Chunk.Cell.Path);
+			ns_yoyo::FAssetExportRecord* CellRecord = Report ? Report->AddAsset(Chunk.Cell.Path, ns_yoyo::EResourceType::Level) : nullptr;
+			const int64 EstimatedBytes = EstimateSceneBytes(Chunk.SceneInfo);
+			Graph.AddJob([&Chunk, CellRecord, &Path, &Manifest, &LevelSource, &LevelSourceHash, SceneEncoding]() -> TFunction<void()>
+			{
+				ns_yoyo::FLevelResource yyCellResource;
+				yyCellResource.Path = Chunk.Cell.Path;
+				yyCellResource.SceneInfo = MoveTemp(Chunk.SceneInfo);
+				{
+					EXPORT_STAGE_SCOPE(CellRecord, SceneBVH);
+					ns_yoyo::BuildStaticMeshBVH(yyCellResource.SceneInfo);
+				}
+				return [yyCellResource = MoveTemp(yyCellResource), CellRecord, &Path, &Manifest, &LevelSource, &LevelSourceHash,
+					SceneEncoding]() mutable
+				{
+					{
+						EXPORT_STAGE_SCOPE(CellRecord, Write);
+						ns_yoyo::EncodeSceneColumns(yyCellResource.SceneInfo, SceneEncoding);
+						bool bOk = SerializeToFile(yyCellResource, Path, GetSerializeOptions());
+						check(bOk);
+					}
+					if (CellRecord)
+					{
+						CellRecord->BytesWritten = IFileManager::Get().FileSize(*(Path + yyCellResource.Path));
+					}
+					EXPORT_STAGE_SCOPE(CellRecord, Manifest);
+					Manifest.Update(yyCellResource.Path, LevelSource.PackageName, LevelSourceHash);
+				};
+			}, EstimatedBytes);
+		}
+	}
+	else
 	{
-		ExportSkeleton(Skeleton, Path);
+		// the culling hierarchy of the scene builds alongside the assets
+		Graph.AddJob([&yySceneInfo, LevelRecord]() -> TFunction<void()>
+		{
+			EXPORT_STAGE_SCOPE(LevelRecord, SceneBVH);
+			ns_yoyo::BuildStaticMeshBVH(yySceneInfo);
+			return nullptr;
+		}, EstimateSceneBytes(yySceneInfo));
 	}
 
+	Manifest.RemoveOutdatedEntries(LevelSource.PackageName, LevelPaths);
+	RunExportGraph(Graph);
+
 	// write to file
 	ns_yoyo::FLevelResource yyLevelResource;
-	yyLevelResource.Path = GetAssetPath<ns_yoyo::EResourceType::Level>(Level);
-	yyLevelResource.SceneInfo = yySceneInfo;
+	yyLevelResource.Path = LevelPath;
+	yyLevelResource.SceneInfo = MoveTemp(yySceneInfo);
+	for (ns_yoyo::FSceneCellChunk& Chunk : CellChunks)
+	{
+		yyLevelResource.SceneInfo.Cells.Add(MoveTemp(Chunk.Cell));
+	}
 
 #if 1
-	bool bOk = SerializeToFile(yyLevelResource, Path);
-	check(bOk);
+	{
+		EXPORT_STAGE_SCOPE(LevelRecord, Write);
+		ns_yoyo::EncodeSceneColumns(yyLevelResource.SceneInfo, SceneEncoding);
+		bool bOk = SerializeToFile(yyLevelResource, Path, GetSerializeOptions());
+		check(bOk);
+	}
+	if (LevelRecord)
+	{
+		LevelRecord->BytesWritten = IFileManager::Get().FileSize(*(Path + yyLevelResource.Path));
+	}
+
+	Manifest.Update(yyLevelResource.Path, LevelSource.PackageName, LevelSourceHash);
 #else
 	TArray<uint8> ByteData;
 	FMemoryWriter BytesWriter(ByteData);
@@ -461,6 +2160,16 @@ void UAssetExporterBPLibrary::ExportMap(UWorld* World, const FString& Path)
 	bool bOk = FFileHelper::SaveArrayToFile(ByteData, *SavePath);
 	check(bOk);
 #endif // 1
+
+	// nothing references the sub-levels loaded for the export anymore, the next garbage collection frees them
+	for (UPackage* LevelPackage : LoadedLevelPackages)
+	{
+		if (UWorld* LevelWorld = UWorld::FindWorldInPackage(LevelPackage))
+		{
+			LevelWorld->ClearFlags(RF_Standalone);
+		}
+		ResetLoaders(LevelPackage);
+	}
 }
 
 /*
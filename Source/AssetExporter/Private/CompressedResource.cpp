@@ -0,0 +1,226 @@
+#include "CompressedResource.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Compression.h"
+
+namespace
+{
+	const TCHAR* CodecNames[] = { TEXT("None"), TEXT("Zlib"), TEXT("LZ4"), TEXT("Oodle") };
+	static_assert(UE_ARRAY_COUNT(CodecNames) == (int32)ns_yoyo::ECompressionCodec::Max, "CodecNames out of date");
+
+	FName GetFormatName(ns_yoyo::ECompressionCodec Codec)
+	{
+		switch (Codec)
+		{
+		case ns_yoyo::ECompressionCodec::Zlib:
+			return NAME_Zlib;
+		case ns_yoyo::ECompressionCodec::LZ4:
+			return NAME_LZ4;
+		case ns_yoyo::ECompressionCodec::Oodle:
+			return FName(TEXT("Oodle"));
+		case ns_yoyo::ECompressionCodec::None:
+		case ns_yoyo::ECompressionCodec::Max:
+		default:
+			return NAME_None;
+		}
+	}
+}
+
+bool ns_yoyo::ParseCompressionCodec(const FString& Name, ECompressionCodec& OutCodec)
+{
+	for (int32 i = 0; i < (int32)ECompressionCodec::Max; ++i)
+	{
+		if (Name == CodecNames[i])
+		{
+			OutCodec = (ECompressionCodec)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const TCHAR* ns_yoyo::GetCompressionCodecName(ECompressionCodec Codec)
+{
+	check(Codec < ECompressionCodec::Max);
+	return CodecNames[(int32)Codec];
+}
+
+bool ns_yoyo::IsCompressionCodecAvailable(ECompressionCodec Codec)
+{
+	return Codec == ECompressionCodec::None || FCompression::IsFormatValid(GetFormatName(Codec));
+}
+
+ns_yoyo::FChunkedCompressionWriter::FChunkedCompressionWriter(FArchive& InInner, EResourceType Type, ECompressionCodec Codec, uint32 ChunkSize)
+	: Inner(InInner)
+{
+	check(Codec != ECompressionCodec::None && ChunkSize > 0);
+	SetIsSaving(true);
+	SetIsPersistent(true);
+
+	FMemory::Memzero(Header);
+	Header.Type = Type;
+	Header.Codec = Codec;
+	Header.Magic = CompressedMagic;
+	Header.FormatVersion = ExportFormatVersion;
+	Header.ChunkSize = ChunkSize;
+
+	// placeholder, patched by Close once the chunk table is known
+	HeaderOffset = Inner.Tell();
+	Inner.Serialize(&Header, sizeof(Header));
+
+	// enough chunks to keep every worker busy
+	MaxPendingChunks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+}
+
+void ns_yoyo::FChunkedCompressionWriter::Serialize(void* Data, int64 Num)
+{
+	const uint8* Src = static_cast<const uint8*>(Data);
+	while (Num > 0)
+	{
+		if (PendingChunks.Num() == 0 || PendingChunks.Last().Num() == (int32)Header.ChunkSize)
+		{
+			if (PendingChunks.Num() == MaxPendingChunks)
+			{
+				CompressPendingChunks();
+			}
+			PendingChunks.AddDefaulted_GetRef().Reserve(Header.ChunkSize);
+		}
+		TArray<uint8>& Chunk = PendingChunks.Last();
+		const int64 NumToCopy = FMath::Min<int64>(Num, Header.ChunkSize - Chunk.Num());
+		Chunk.Append(Src, NumToCopy);
+		Src += NumToCopy;
+		Num -= NumToCopy;
+	}
+}
+
+int64 ns_yoyo::FChunkedCompressionWriter::Tell()
+{
+	int64 Pending = 0;
+	for (const TArray<uint8>& Chunk : PendingChunks)
+	{
+		Pending += Chunk.Num();
+	}
+	return Header.UncompressedSize + Pending;
+}
+
+void ns_yoyo::FChunkedCompressionWriter::CompressPendingChunks()
+{
+	const FName FormatName = GetFormatName(Header.Codec);
+	TArray<TArray<uint8>> CompressedChunks;
+	CompressedChunks.SetNum(PendingChunks.Num());
+	ParallelFor(PendingChunks.Num(), [this, &FormatName, &CompressedChunks](int32 ChunkIndex)
+	{
+		const TArray<uint8>& Chunk = PendingChunks[ChunkIndex];
+		TArray<uint8>& Compressed = CompressedChunks[ChunkIndex];
+		int32 CompressedSize = FCompression::CompressMemoryBound(FormatName, Chunk.Num());
+		Compressed.SetNumUninitialized(CompressedSize);
+		if (!FCompression::CompressMemory(FormatName, Compressed.GetData(), CompressedSize, Chunk.GetData(), Chunk.Num())
+			|| CompressedSize >= Chunk.Num())
+		{
+			// incompressible, stored as is
+			Compressed.Reset();
+			return;
+		}
+		Compressed.SetNum(CompressedSize, false);
+	});
+
+	// chunks go out in order so the payload stays deterministic
+	for (int32 ChunkIndex = 0; ChunkIndex < PendingChunks.Num(); ++ChunkIndex)
+	{
+		TArray<uint8>& Chunk = PendingChunks[ChunkIndex];
+		TArray<uint8>& Stored = CompressedChunks[ChunkIndex].Num() > 0 ? CompressedChunks[ChunkIndex] : Chunk;
+		FCompressedChunk& Entry = ChunkTable.AddZeroed_GetRef();
+		Entry.Offset = Inner.Tell();
+		Entry.CompressedSize = Stored.Num();
+		Entry.UncompressedSize = Chunk.Num();
+		Inner.Serialize(Stored.GetData(), Stored.Num());
+		Header.UncompressedSize += Chunk.Num();
+	}
+	PendingChunks.Reset();
+}
+
+bool ns_yoyo::FChunkedCompressionWriter::Close()
+{
+	CompressPendingChunks();
+
+	Header.NumChunks = ChunkTable.Num();
+	Header.ChunkTableOffset = Inner.Tell();
+	Inner.Serialize(ChunkTable.GetData(), ChunkTable.Num() * sizeof(FCompressedChunk));
+
+	const int64 EndOffset = Inner.Tell();
+	Inner.Seek(HeaderOffset);
+	Inner.Serialize(&Header, sizeof(Header));
+	Inner.Seek(EndOffset);
+	return !Inner.IsError() && !IsError();
+}
+
+bool ns_yoyo::IsCompressedResource(const TArray<uint8>& FileData)
+{
+	FCompressedHeader Header;
+	if (FileData.Num() < sizeof(Header))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&Header, FileData.GetData(), sizeof(Header));
+	return Header.Magic == CompressedMagic;
+}
+
+bool ns_yoyo::DecompressResource(const TArray<uint8>& FileData, TArray<uint8>& OutPayload)
+{
+	if (!IsCompressedResource(FileData))
+	{
+		return false;
+	}
+	FCompressedHeader Header;
+	FMemory::Memcpy(&Header, FileData.GetData(), sizeof(Header));
+	if (Header.Codec == ECompressionCodec::None || Header.Codec >= ECompressionCodec::Max
+		|| Header.ChunkTableOffset + Header.NumChunks * sizeof(FCompressedChunk) > (uint64)FileData.Num())
+	{
+		return false;
+	}
+	const FCompressedChunk* ChunkTable = reinterpret_cast<const FCompressedChunk*>(FileData.GetData() + Header.ChunkTableOffset);
+
+	// the chunks must tile the payload exactly, every one but the last being ChunkSize
+	uint64 TiledSize = 0;
+	for (uint32 ChunkIndex = 0; ChunkIndex < Header.NumChunks; ++ChunkIndex)
+	{
+		const uint32 ChunkSize = ChunkTable[ChunkIndex].UncompressedSize;
+		const bool bLast = ChunkIndex + 1 == Header.NumChunks;
+		if (ChunkSize == 0 || ChunkSize > Header.ChunkSize || (!bLast && ChunkSize != Header.ChunkSize))
+		{
+			return false;
+		}
+		TiledSize += ChunkSize;
+	}
+	// and fit the payload array
+	if (TiledSize != Header.UncompressedSize || Header.UncompressedSize > MAX_int32)
+	{
+		return false;
+	}
+
+	OutPayload.SetNumUninitialized(Header.UncompressedSize);
+	const FName FormatName = GetFormatName(Header.Codec);
+	TAtomic<bool> bOk(true);
+	ParallelFor(Header.NumChunks, [&](int32 ChunkIndex)
+	{
+		const FCompressedChunk& Chunk = ChunkTable[ChunkIndex];
+		const uint64 DestOffset = (uint64)ChunkIndex * Header.ChunkSize;
+		if (Chunk.Offset + Chunk.CompressedSize > (uint64)FileData.Num()
+			|| DestOffset + Chunk.UncompressedSize > Header.UncompressedSize)
+		{
+			bOk = false;
+			return;
+		}
+		uint8* Dest = OutPayload.GetData() + DestOffset;
+		const uint8* Src = FileData.GetData() + Chunk.Offset;
+		if (Chunk.CompressedSize == Chunk.UncompressedSize)
+		{
+			FMemory::Memcpy(Dest, Src, Chunk.UncompressedSize);
+		}
+		else if (!FCompression::UncompressMemory(FormatName, Dest, Chunk.UncompressedSize, Src, Chunk.CompressedSize))
+		{
+			bOk = false;
+		}
+	});
+	return bOk;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Compressed variant of the resource files.
+	*
+	* FCompressedHeader
+	* chunks, each compressed on its own
+	* FCompressedChunk[NumChunks] at ChunkTableOffset
+	*
+	* The payload, a regular or mapped resource stream, is cut into ChunkSize pieces that
+	* are compressed independently, so both export and load can spread them over cores.
+	* A chunk whose CompressedSize equals its UncompressedSize is stored as is.
+	*/
+	constexpr uint32 CompressedMagic = 0x5A435959; // "YYCZ"
+
+	enum class ECompressionCodec : uint8
+	{
+		None,
+		Zlib,
+		LZ4,
+		Oodle,
+		Max
+	};
+
+	struct FCompressedHeader
+	{
+		EResourceType Type;
+		ECompressionCodec Codec;
+		uint8 Pad[2];
+		uint32 Magic;
+		uint32 FormatVersion;
+		// uncompressed size of every chunk but the last
+		uint32 ChunkSize;
+		uint64 UncompressedSize;
+		uint64 ChunkTableOffset;
+		uint32 NumChunks;
+		uint32 Pad2;
+	};
+	static_assert(sizeof(FCompressedHeader) == 40, "FCompressedHeader must stay 40 bytes");
+
+	struct FCompressedChunk
+	{
+		// from the start of the file
+		uint64 Offset;
+		uint32 CompressedSize;
+		uint32 UncompressedSize;
+	};
+	static_assert(sizeof(FCompressedChunk) == 16, "FCompressedChunk must stay 16 bytes");
+
+	bool ParseCompressionCodec(const FString& Name, ECompressionCodec& OutCodec);
+	const TCHAR* GetCompressionCodecName(ECompressionCodec Codec);
+	// false when the codec isn't available in this build, Oodle needs its plugin
+	bool IsCompressionCodecAvailable(ECompressionCodec Codec);
+
+	/*
+	* Archive compressing everything serialized into it chunk by chunk into Inner.
+	* Only a few chunks are held at a time, they are compressed in parallel once
+	* enough of them are filled. Close() must be called before closing Inner.
+	*/
+	class FChunkedCompressionWriter : public FArchive
+	{
+	public:
+		FChunkedCompressionWriter(FArchive& Inner, EResourceType Type, ECompressionCodec Codec, uint32 ChunkSize);
+
+		virtual void Serialize(void* Data, int64 Num) override;
+		virtual int64 Tell() override;
+		virtual bool Close() override;
+		virtual FString GetArchiveName() const override { return TEXT("FChunkedCompressionWriter"); }
+
+	private:
+		void CompressPendingChunks();
+
+		FArchive& Inner;
+		FCompressedHeader Header;
+		int64 HeaderOffset;
+		int32 MaxPendingChunks;
+		TArray<TArray<uint8>> PendingChunks;
+		TArray<FCompressedChunk> ChunkTable;
+	};
+
+	// decompresses a whole compressed file in parallel, false if FileData isn't a valid compressed resource
+	bool DecompressResource(const TArray<uint8>& FileData, TArray<uint8>& OutPayload);
+
+	bool IsCompressedResource(const TArray<uint8>& FileData);
+}
@@ -0,0 +1,564 @@
+#include "CoreMinimal.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "AssetExporterBPLibrary.h"
+#include "Dom/JsonObject.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ReferenceSkeleton.h"
+#include "Rendering/PositionVertexBuffer.h"
+#include "Rendering/SkeletalMeshLODRenderData.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Rendering/StaticMeshVertexBuffer.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/MemoryWriter.h"
+#include "StaticMeshResources.h"
+#include "UObject/Package.h"
+
+#include "CompressedResource.h"
+#include "ExportTypes.h"
+
+/*
+* Console commands timing the hot loops of the exporter on synthetic data.
+* They don't need any asset, run them from the editor console or with -ExecCmds,
+* except AssetExporter.Bench.Compression which reads an existing export.
+* The export regression suite lives in the AssetExporter.Perf automation tests at the end of the file.
+*/
+
+namespace
+{
+	// the per-vertex loop ExportVertexBuffer used before the bulk kernel, kept as reference
+	void ExportVertexBufferPerVertex(TArray<float>& FloatRawData, FStaticMeshVertexBuffers& VertexBuffers)
+	{
+		const uint32 NumVertices = VertexBuffers.PositionVertexBuffer.GetNumVertices();
+		for (uint32 i = 0; i < NumVertices; ++i)
+		{
+			// position
+			auto Position = VertexBuffers.PositionVertexBuffer.VertexPosition(i);
+			FloatRawData.Append({ Position.X, Position.Y, Position.Z });
+			// normal
+			auto Normal = VertexBuffers.StaticMeshVertexBuffer.VertexTangentZ(i);
+			FloatRawData.Append({ Normal.X, Normal.Y, Normal.Z });
+			// uv
+			auto UV = VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 0);
+			FloatRawData.Append({ UV.X, UV.Y });
+		}
+	}
+
+	void InitSyntheticVertexBuffers(FStaticMeshVertexBuffers& VertexBuffers, uint32 NumVertices,
+		bool bHighPrecisionTangents, bool bFullPrecisionUVs)
+	{
+		FRandomStream Random(NumVertices);
+		VertexBuffers.PositionVertexBuffer.Init(NumVertices);
+		VertexBuffers.StaticMeshVertexBuffer.SetUseHighPrecisionTangentBasis(bHighPrecisionTangents);
+		VertexBuffers.StaticMeshVertexBuffer.SetUseFullPrecisionUVs(bFullPrecisionUVs);
+		VertexBuffers.StaticMeshVertexBuffer.Init(NumVertices, 2);
+		for (uint32 i = 0; i < NumVertices; ++i)
+		{
+			VertexBuffers.PositionVertexBuffer.VertexPosition(i) = Random.GetUnitVector() * 100.f;
+			const FVector TangentZ = Random.GetUnitVector();
+			const FVector TangentX = FVector::CrossProduct(TangentZ, Random.GetUnitVector()).GetSafeNormal();
+			VertexBuffers.StaticMeshVertexBuffer.SetVertexTangents(i, TangentX, FVector::CrossProduct(TangentZ, TangentX), TangentZ);
+			VertexBuffers.StaticMeshVertexBuffer.SetVertexUV(i, 0, FVector2D(Random.FRand(), Random.FRand()));
+			VertexBuffers.StaticMeshVertexBuffer.SetVertexUV(i, 1, FVector2D(Random.FRand(), Random.FRand()));
+		}
+	}
+
+	template<typename TFunc>
+	double BestOfSeconds(int32 NumRuns, TFunc&& Func)
+	{
+		double Best = DBL_MAX;
+		for (int32 Run = 0; Run < NumRuns; ++Run)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Func();
+			Best = FMath::Min(Best, FPlatformTime::Seconds() - StartTime);
+		}
+		return Best;
+	}
+
+	void BenchVertexBuffer(const TArray<FString>& Args)
+	{
+		const uint32 NumVertices = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000;
+		const int32 NumRuns = 5;
+
+		for (int32 Format = 0; Format < 4; ++Format)
+		{
+			const bool bHighPrecisionTangents = (Format & 1) != 0;
+			const bool bFullPrecisionUVs = (Format & 2) != 0;
+			FStaticMeshVertexBuffers VertexBuffers;
+			InitSyntheticVertexBuffers(VertexBuffers, NumVertices, bHighPrecisionTangents, bFullPrecisionUVs);
+
+			TArray<float> Reference;
+			ns_yoyo::FVertexBuffer Bulk;
+			const double PerVertexSeconds = BestOfSeconds(NumRuns, [&]()
+			{
+				Reference.Empty();
+				ExportVertexBufferPerVertex(Reference, VertexBuffers);
+			});
+			const double BulkSeconds = BestOfSeconds(NumRuns, [&]()
+			{
+				Bulk.RawData.Empty();
+				ns_yoyo::ExportVertexBuffer(Bulk, VertexBuffers);
+			});
+
+			const bool bIdentical = Reference.Num() * sizeof(float) == Bulk.RawData.Num()
+				&& FMemory::Memcmp(Reference.GetData(), Bulk.RawData.GetData(), Bulk.RawData.Num()) == 0;
+			UE_LOG(LogTemp, Log, TEXT("VertexBuffer %u verts, high precision tangents %d, full precision uvs %d: per vertex %.2f ms, bulk %.2f ms (%.1fx), identical %d"),
+				NumVertices, bHighPrecisionTangents, bFullPrecisionUVs,
+				PerVertexSeconds * 1000.0, BulkSeconds * 1000.0, PerVertexSeconds / FMath::Max(BulkSeconds, 1e-9), bIdentical);
+		}
+	}
+
+	FAutoConsoleCommand BenchVertexBufferCommand(
+		TEXT("AssetExporter.Bench.VertexBuffer"),
+		TEXT("Times ExportVertexBuffer against the old per-vertex loop for every tangent/uv precision.\n")
+		TEXT("Usage: AssetExporter.Bench.VertexBuffer [NumVertices=1000000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchVertexBuffer));
+
+	void BenchCompression(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: AssetExporter.Bench.Compression <ExportRoot> [ChunkSizeKB=256]"));
+			return;
+		}
+		const uint32 ChunkSize = (Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 4) : 256) * 1024;
+		const int32 NumRuns = 3;
+
+		// payloads of every exported resource, already compressed files are measured uncompressed
+		TArray<TArray<uint8>> Payloads;
+		uint64 TotalSize = 0;
+		for (const TCHAR* Extension : { TEXT("*.mesh"), TEXT("*.skelmesh"), TEXT("*.anim"), TEXT("*.skel"), TEXT("*.scene") })
+		{
+			TArray<FString> Files;
+			IFileManager::Get().FindFilesRecursive(Files, *Args[0], Extension, true, false);
+			for (const FString& File : Files)
+			{
+				TArray<uint8> FileData;
+				if (!FFileHelper::LoadFileToArray(FileData, *File) || FileData.Num() == 0)
+				{
+					continue;
+				}
+				TArray<uint8>& Payload = Payloads.AddDefaulted_GetRef();
+				if (!ns_yoyo::DecompressResource(FileData, Payload))
+				{
+					Payload = MoveTemp(FileData);
+				}
+				TotalSize += Payload.Num();
+			}
+		}
+		if (TotalSize == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("No exported resources under %s"), *Args[0]);
+			return;
+		}
+		const double TotalMB = TotalSize / (1024.0 * 1024.0);
+
+		for (int32 Codec = 1; Codec < (int32)ns_yoyo::ECompressionCodec::Max; ++Codec)
+		{
+			const ns_yoyo::ECompressionCodec CompressionCodec = (ns_yoyo::ECompressionCodec)Codec;
+			if (!ns_yoyo::IsCompressionCodecAvailable(CompressionCodec))
+			{
+				UE_LOG(LogTemp, Log, TEXT("Compression %s: not available"), ns_yoyo::GetCompressionCodecName(CompressionCodec));
+				continue;
+			}
+
+			TArray<TArray<uint8>> Compressed;
+			Compressed.SetNum(Payloads.Num());
+			const double CompressSeconds = BestOfSeconds(NumRuns, [&]()
+			{
+				for (int32 i = 0; i < Payloads.Num(); ++i)
+				{
+					Compressed[i].Reset();
+					FMemoryWriter MemoryWriter(Compressed[i]);
+					ns_yoyo::FChunkedCompressionWriter Writer(MemoryWriter, (ns_yoyo::EResourceType)Payloads[i][0], CompressionCodec, ChunkSize);
+					Writer.Serialize(Payloads[i].GetData(), Payloads[i].Num());
+					Writer.Close();
+				}
+			});
+
+			TArray<TArray<uint8>> Decompressed;
+			Decompressed.SetNum(Payloads.Num());
+			bool bRoundTrip = true;
+			const double DecompressSeconds = BestOfSeconds(NumRuns, [&]()
+			{
+				for (int32 i = 0; i < Payloads.Num(); ++i)
+				{
+					bRoundTrip &= ns_yoyo::DecompressResource(Compressed[i], Decompressed[i]);
+				}
+			});
+
+			uint64 CompressedSize = 0;
+			for (int32 i = 0; i < Payloads.Num(); ++i)
+			{
+				CompressedSize += Compressed[i].Num();
+				bRoundTrip &= Decompressed[i] == Payloads[i];
+			}
+			UE_LOG(LogTemp, Log, TEXT("Compression %s, %d files, %.2f MB, %u KB chunks: ratio %.3f, compress %.1f MB/s, decompress %.1f MB/s, round trip %d"),
+				ns_yoyo::GetCompressionCodecName(CompressionCodec), Payloads.Num(), TotalMB, ChunkSize / 1024,
+				(double)TotalSize / FMath::Max<uint64>(CompressedSize, 1),
+				TotalMB / FMath::Max(CompressSeconds, 1e-9), TotalMB / FMath::Max(DecompressSeconds, 1e-9), bRoundTrip);
+		}
+	}
+
+	FAutoConsoleCommand BenchCompressionCommand(
+		TEXT("AssetExporter.Bench.Compression"),
+		TEXT("Compresses every resource of an export with each available codec and reports ratio and MB/s.\n")
+		TEXT("Usage: AssetExporter.Bench.Compression <ExportRoot> [ChunkSizeKB=256]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchCompression));
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* AssetExporter.Perf is the export regression suite: every test exports synthetic transient assets
+* of several sizes and fails when a case gets slower than the stored baseline allows.
+* Run with "Automation RunTests AssetExporter.Perf", see the AssetExporter.Perf.* console variables
+* for the baseline, the tolerance and the quick sizes.
+*/
+
+namespace
+{
+	// a grid of NumVertices vertices, two triangles per quad, like a tessellated surface
+	void MakeSyntheticIndices(uint32 NumVertices, TArray<uint32>& OutIndices)
+	{
+		const uint32 Width = FMath::Max(FMath::FloorToInt(FMath::Sqrt((float)NumVertices)), 2);
+		const uint32 Height = NumVertices / Width;
+		OutIndices.Reset((Width - 1) * (Height - 1) * 6);
+		for (uint32 Y = 0; Y + 1 < Height; ++Y)
+		{
+			for (uint32 X = 0; X + 1 < Width; ++X)
+			{
+				const uint32 V0 = Y * Width + X;
+				OutIndices.Append({ V0, V0 + Width, V0 + 1, V0 + 1, V0 + Width, V0 + Width + 1 });
+			}
+		}
+	}
+
+	// every synthetic asset gets its own transient package, so each exports to its own file
+	UPackage* CreateBenchPackage(const FString& Name)
+	{
+		UPackage* Package = CreatePackage(*(TEXT("/Game/AssetExporterBench/") + Name));
+		Package->SetFlags(RF_Transient);
+		return Package;
+	}
+
+	UStaticMesh* CreateSyntheticStaticMesh(const FString& Name, uint32 NumVertices)
+	{
+		UStaticMesh* Mesh = NewObject<UStaticMesh>(CreateBenchPackage(Name), *Name, RF_Transient);
+		Mesh->RenderData = MakeUnique<FStaticMeshRenderData>();
+		Mesh->RenderData->AllocateLODResources(1);
+		FStaticMeshLODResources& LODResource = Mesh->RenderData->LODResources[0];
+		InitSyntheticVertexBuffers(LODResource.VertexBuffers, NumVertices, false, false);
+
+		TArray<uint32> Indices;
+		MakeSyntheticIndices(NumVertices, Indices);
+		LODResource.IndexBuffer.SetIndices(Indices, NumVertices > MAX_uint16 ? EIndexBufferStride::Force32Bit : EIndexBufferStride::Force16Bit);
+
+		FStaticMeshSection& Section = LODResource.Sections.AddDefaulted_GetRef();
+		Section.FirstIndex = 0;
+		Section.NumTriangles = Indices.Num() / 3;
+		Section.MinVertexIndex = 0;
+		Section.MaxVertexIndex = NumVertices - 1;
+		return Mesh;
+	}
+
+	// a binary tree of bones, merged into a skeleton through a mesh holding the reference skeleton
+	USkeleton* CreateSyntheticSkeleton(const FString& Name, int32 NumBones)
+	{
+		UPackage* Package = CreateBenchPackage(Name);
+		USkeletalMesh* RefMesh = NewObject<USkeletalMesh>(Package, *(Name + TEXT("_Ref")), RF_Transient);
+		{
+			FReferenceSkeletonModifier Modifier(RefMesh->RefSkeleton, nullptr);
+			for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+			{
+				const FName BoneName(*FString::Printf(TEXT("Bone%d"), BoneIndex));
+				const int32 ParentIndex = BoneIndex == 0 ? INDEX_NONE : (BoneIndex - 1) / 2;
+				Modifier.Add(FMeshBoneInfo(BoneName, BoneName.ToString(), ParentIndex), FTransform(FVector(0.f, 0.f, 10.f)));
+			}
+		}
+		USkeleton* Skeleton = NewObject<USkeleton>(Package, *Name, RF_Transient);
+		Skeleton->MergeAllBonesToBoneTree(RefMesh);
+		return Skeleton;
+	}
+
+	USkeletalMesh* CreateSyntheticSkeletalMesh(const FString& Name, uint32 NumVertices, USkeleton* Skeleton)
+	{
+		USkeletalMesh* SkelMesh = NewObject<USkeletalMesh>(CreateBenchPackage(Name), *Name, RF_Transient);
+		SkelMesh->Skeleton = Skeleton;
+		SkelMesh->AllocateResourceForRendering();
+		FSkeletalMeshLODRenderData* LODRenderData = new FSkeletalMeshLODRenderData();
+		SkelMesh->GetResourceForRendering()->LODRenderData.Add(LODRenderData);
+		InitSyntheticVertexBuffers(LODRenderData->StaticVertexBuffers, NumVertices, false, false);
+
+		TArray<uint32> Indices;
+		MakeSyntheticIndices(NumVertices, Indices);
+		LODRenderData->MultiSizeIndexContainer.RebuildIndexBuffer(NumVertices > MAX_uint16 ? sizeof(uint32) : sizeof(uint16), Indices);
+
+		// one section using up to 256 bones, 4 influences per vertex
+		const int32 NumBones = FMath::Min(Skeleton->GetReferenceSkeleton().GetNum(), 256);
+		FSkelMeshRenderSection& Section = LODRenderData->RenderSections.AddDefaulted_GetRef();
+		Section.BaseIndex = 0;
+		Section.NumTriangles = Indices.Num() / 3;
+		Section.BaseVertexIndex = 0;
+		Section.NumVertices = NumVertices;
+		Section.MaxBoneInfluences = 4;
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+		{
+			Section.BoneMap.Add(BoneIndex);
+		}
+
+		FRandomStream Random(NumVertices);
+		TArray<FSkinWeightInfo> Weights;
+		Weights.SetNumZeroed(NumVertices);
+		for (FSkinWeightInfo& Weight : Weights)
+		{
+			for (int32 Influence = 0; Influence < 4; ++Influence)
+			{
+				Weight.InfluenceBones[Influence] = Random.RandHelper(NumBones);
+			}
+			Weight.InfluenceWeights[0] = 128;
+			Weight.InfluenceWeights[1] = 64;
+			Weight.InfluenceWeights[2] = 32;
+			Weight.InfluenceWeights[3] = 31;
+		}
+		LODRenderData->SkinWeightVertexBuffer.SetMaxBoneInfluences(4);
+		LODRenderData->SkinWeightVertexBuffer.SetUse16BitBoneIndex(NumBones > 256);
+		LODRenderData->SkinWeightVertexBuffer = Weights;
+		return SkelMesh;
+	}
+
+	UAnimSequence* CreateSyntheticAnimSequence(const FString& Name, USkeleton* Skeleton, int32 NumFrames)
+	{
+		UAnimSequence* AnimSequence = NewObject<UAnimSequence>(CreateBenchPackage(Name), *Name, RF_Transient);
+		AnimSequence->SetSkeleton(Skeleton);
+		AnimSequence->SetRawNumberOfFrame(NumFrames);
+		const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+		FRandomStream Random(NumFrames);
+		for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); ++BoneIndex)
+		{
+			// smooth motion with a little noise, so key reduction has something to do and something to keep
+			FRawAnimSequenceTrack Track;
+			const float Phase = Random.FRand() * PI;
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				const float Time = Frame / 30.f;
+				Track.PosKeys.Add(FVector(FMath::Sin(Time + Phase) * 5.f, 0.f, 10.f + Random.FRand() * 0.001f));
+				Track.RotKeys.Add(FQuat(FVector::UpVector, FMath::Sin(Time * 2.f + Phase)));
+				Track.ScaleKeys.Add(FVector::OneVector);
+			}
+			AnimSequence->AddNewRawTrack(RefSkeleton.GetBoneName(BoneIndex), &Track);
+		}
+		return AnimSequence;
+	}
+
+	TAutoConsoleVariable<int32> CVarPerfQuick(
+		TEXT("AssetExporter.Perf.Quick"),
+		0,
+		TEXT("Skip the 2M vertex meshes and the 500 bones x 10k frames animation in the AssetExporter.Perf tests."),
+		ECVF_Default);
+
+	TAutoConsoleVariable<int32> CVarPerfUpdateBaseline(
+		TEXT("AssetExporter.Perf.UpdateBaseline"),
+		0,
+		TEXT("Record the times of the AssetExporter.Perf tests as the new baseline instead of comparing against it."),
+		ECVF_Default);
+
+	TAutoConsoleVariable<float> CVarPerfTolerance(
+		TEXT("AssetExporter.Perf.Tolerance"),
+		0.1f,
+		TEXT("How much slower than the baseline an AssetExporter.Perf case may get before the test fails, 0.1 is 10%."),
+		ECVF_Default);
+
+	TAutoConsoleVariable<FString> CVarPerfBaseline(
+		TEXT("AssetExporter.Perf.Baseline"),
+		TEXT(""),
+		TEXT("Baseline file of the AssetExporter.Perf tests, Saved/AssetExporter/BenchBaseline.json when empty."),
+		ECVF_Default);
+
+	struct FBenchCase
+	{
+		FString Name;
+		// vertices of meshes, keys of animations, bones of skeletons
+		uint64 NumElements;
+		const TCHAR* ElementName;
+		TFunction<void(const FString&)> Export;
+		FString ResourcePath;
+	};
+
+	// sizes from small props to the largest characters we ship
+	TArray<uint32> GetMeshSizes()
+	{
+		TArray<uint32> MeshSizes = { 1000, 65536, 500000 };
+		if (CVarPerfQuick.GetValueOnGameThread() == 0)
+		{
+			MeshSizes.Add(2000000);
+		}
+		return MeshSizes;
+	}
+
+	// bones x frames
+	TArray<TPair<int32, int32>> GetAnimSizes()
+	{
+		TArray<TPair<int32, int32>> AnimSizes = { { 100, 300 }, { 200, 2000 } };
+		if (CVarPerfQuick.GetValueOnGameThread() == 0)
+		{
+			AnimSizes.Add({ 500, 10000 });
+		}
+		return AnimSizes;
+	}
+
+	/*
+	* Exports every case, reports MB/s and elements/s and compares the times against the baseline,
+	* every case slower than the tolerance allows is an error of the test.
+	* The baseline holds the cases of every test, updating it only replaces the cases that ran.
+	*/
+	void RunBenchCases(FAutomationTestBase& Test, TArray<FBenchCase>& Cases)
+	{
+		const bool bUpdateBaseline = CVarPerfUpdateBaseline.GetValueOnGameThread() != 0;
+		const float Tolerance = CVarPerfTolerance.GetValueOnGameThread();
+		FString BaselinePath = CVarPerfBaseline.GetValueOnGameThread();
+		if (BaselinePath.IsEmpty())
+		{
+			BaselinePath = FPaths::ProjectSavedDir() / TEXT("AssetExporter/BenchBaseline.json");
+		}
+		const int32 NumRuns = 3;
+		const FString OutputRoot = FPaths::ProjectIntermediateDir() / TEXT("AssetExporterBench");
+
+		TSharedPtr<FJsonObject> Baseline;
+		FString BaselineJson;
+		if (FFileHelper::LoadFileToString(BaselineJson, *BaselinePath))
+		{
+			FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineJson), Baseline);
+		}
+
+		TSharedRef<FJsonObject> Results = MakeShared<FJsonObject>();
+		int32 NumRegressions = 0;
+		for (const FBenchCase& Case : Cases)
+		{
+			// the transient packages have no file, so the manifest never skips them
+			const double Seconds = BestOfSeconds(NumRuns, [&Case, &OutputRoot]() { Case.Export(OutputRoot); });
+			const int64 Bytes = IFileManager::Get().FileSize(*(OutputRoot + Case.ResourcePath));
+			Results->SetNumberField(Case.Name, Seconds);
+
+			FString Comparison;
+			double BaselineSeconds = 0.0;
+			bool bRegression = false;
+			if (!bUpdateBaseline && Baseline && Baseline->TryGetNumberField(Case.Name, BaselineSeconds) && BaselineSeconds > 0.0)
+			{
+				bRegression = Seconds > BaselineSeconds * (1.0 + Tolerance);
+				NumRegressions += bRegression ? 1 : 0;
+				Comparison = FString::Printf(TEXT(", baseline %.2f ms (%+.1f%%)"), BaselineSeconds * 1000.0,
+					(Seconds / BaselineSeconds - 1.0) * 100.0);
+			}
+			const FString Message = FString::Printf(TEXT("%s: %.2f ms, %.2f MB, %.1f MB/s, %.2f M %s/s%s"),
+				*Case.Name, Seconds * 1000.0, Bytes / (1024.0 * 1024.0),
+				Bytes / (1024.0 * 1024.0) / FMath::Max(Seconds, 1e-9),
+				Case.NumElements / 1e6 / FMath::Max(Seconds, 1e-9), Case.ElementName, *Comparison);
+			if (bRegression)
+			{
+				Test.AddError(FString::Printf(TEXT("%s, more than %.0f%% slower than the baseline"), *Message, Tolerance * 100.f));
+			}
+			else
+			{
+				Test.AddInfo(Message);
+			}
+		}
+
+		if (bUpdateBaseline)
+		{
+			TSharedRef<FJsonObject> NewBaseline = Baseline ? Baseline.ToSharedRef() : MakeShared<FJsonObject>();
+			for (const TPair<FString, TSharedPtr<FJsonValue>>& Result : Results->Values)
+			{
+				NewBaseline->SetField(Result.Key, Result.Value);
+			}
+			FString ResultsJson;
+			FJsonSerializer::Serialize(NewBaseline, TJsonWriterFactory<>::Create(&ResultsJson));
+			if (FFileHelper::SaveStringToFile(ResultsJson, *BaselinePath))
+			{
+				Test.AddInfo(FString::Printf(TEXT("Saved baseline %s"), *BaselinePath));
+			}
+			else
+			{
+				Test.AddError(FString::Printf(TEXT("Failed to save baseline %s"), *BaselinePath));
+			}
+		}
+		else if (!Baseline)
+		{
+			Test.AddInfo(FString::Printf(TEXT("No baseline at %s, run with AssetExporter.Perf.UpdateBaseline 1 to record one"), *BaselinePath));
+		}
+		else
+		{
+			Test.AddInfo(FString::Printf(TEXT("%d of %d cases more than %.0f%% slower than the baseline"), NumRegressions, Cases.Num(), Tolerance * 100.f));
+		}
+
+		IFileManager::Get().DeleteDirectory(*OutputRoot, false, true);
+		Cases.Empty();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAssetExporterPerfStaticMeshTest, "AssetExporter.Perf.StaticMesh",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FAssetExporterPerfStaticMeshTest::RunTest(const FString& Parameters)
+{
+	TArray<FBenchCase> Cases;
+	for (uint32 NumVertices : GetMeshSizes())
+	{
+		UStaticMesh* StaticMesh = CreateSyntheticStaticMesh(FString::Printf(TEXT("StaticMesh_%u"), NumVertices), NumVertices);
+		Cases.Add({ StaticMesh->GetName(), NumVertices, TEXT("vertices"),
+			[StaticMesh](const FString& Path) { UAssetExporterBPLibrary::ExportStaticMesh(StaticMesh, Path); },
+			TEXT("/AssetExporterBench/") + StaticMesh->GetName() + TEXT(".mesh") });
+	}
+	RunBenchCases(*this, Cases);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAssetExporterPerfSkeletalMeshTest, "AssetExporter.Perf.SkeletalMesh",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FAssetExporterPerfSkeletalMeshTest::RunTest(const FString& Parameters)
+{
+	TArray<FBenchCase> Cases;
+	USkeleton* MeshSkeleton = CreateSyntheticSkeleton(TEXT("MeshSkeleton_100"), 100);
+	for (uint32 NumVertices : GetMeshSizes())
+	{
+		USkeletalMesh* SkelMesh = CreateSyntheticSkeletalMesh(FString::Printf(TEXT("SkeletalMesh_%u"), NumVertices), NumVertices, MeshSkeleton);
+		Cases.Add({ SkelMesh->GetName(), NumVertices, TEXT("vertices"),
+			[SkelMesh](const FString& Path) { UAssetExporterBPLibrary::ExportSkeletalMesh(SkelMesh, Path); },
+			TEXT("/AssetExporterBench/") + SkelMesh->GetName() + TEXT(".skelmesh") });
+	}
+	RunBenchCases(*this, Cases);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAssetExporterPerfAnimationTest, "AssetExporter.Perf.Animation",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FAssetExporterPerfAnimationTest::RunTest(const FString& Parameters)
+{
+	TArray<FBenchCase> Cases;
+	for (const TPair<int32, int32>& AnimSize : GetAnimSizes())
+	{
+		USkeleton* Skeleton = CreateSyntheticSkeleton(FString::Printf(TEXT("Skeleton_%d"), AnimSize.Key), AnimSize.Key);
+		Cases.Add({ Skeleton->GetName(), (uint64)AnimSize.Key, TEXT("bones"),
+			[Skeleton](const FString& Path) { UAssetExporterBPLibrary::ExportSkeleton(Skeleton, Path); },
+			TEXT("/AssetExporterBench/") + Skeleton->GetName() + TEXT(".skel") });
+		UAnimSequence* AnimSequence = CreateSyntheticAnimSequence(
+			FString::Printf(TEXT("AnimSequence_%dx%d"), AnimSize.Key, AnimSize.Value), Skeleton, AnimSize.Value);
+		Cases.Add({ AnimSequence->GetName(), (uint64)AnimSize.Key * AnimSize.Value, TEXT("keys"),
+			[AnimSequence](const FString& Path) { UAssetExporterBPLibrary::ExportAnimSequence(AnimSequence, Path); },
+			TEXT("/AssetExporterBench/") + AnimSequence->GetName() + TEXT(".anim") });
+	}
+	RunBenchCases(*this, Cases);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,221 @@
+#include "ExportJobGraph.h"
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+ns_yoyo::FExportJobGraph::~FExportJobGraph()
+{
+	check(WorkerEvents.Num() == 0 && !WriterEvent);
+}
+
+int32 ns_yoyo::FExportJobGraph::AddJob(FConvertFunction Convert, int64 EstimatedBytes)
+{
+	FJob& Job = Jobs.AddDefaulted_GetRef();
+	Job.Convert = MoveTemp(Convert);
+	Job.EstimatedBytes = FMath::Max<int64>(EstimatedBytes, 0);
+	return Jobs.Num() - 1;
+}
+
+void ns_yoyo::FExportJobGraph::AddPrerequisite(int32 Job, int32 Prerequisite)
+{
+	check(Jobs.IsValidIndex(Job) && Jobs.IsValidIndex(Prerequisite) && Job != Prerequisite);
+	Jobs[Prerequisite].Dependents.Add(Job);
+	++Jobs[Job].NumPrerequisites;
+}
+
+int32 ns_yoyo::FExportJobGraph::PopReadyJob()
+{
+	// in the order they became ready, a job that doesn't fit lets smaller ones pass
+	for (int32 i = 0; i < ReadyJobs.Num(); ++i)
+	{
+		const int32 JobIndex = ReadyJobs[i];
+		const int64 Bytes = Jobs[JobIndex].EstimatedBytes;
+		if (BytesInFlight == 0 || BytesInFlight + Bytes <= Budget)
+		{
+			ReadyJobs.RemoveAt(i);
+			BytesInFlight += Bytes;
+			PeakBytesInFlight = FMath::Max(PeakBytesInFlight, BytesInFlight);
+			return JobIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void ns_yoyo::FExportJobGraph::CompleteJob(int32 JobIndex)
+{
+	{
+		FScopeLock ScopeLock(&StateLock);
+		FJob& Job = Jobs[JobIndex];
+		BytesInFlight -= Job.EstimatedBytes;
+		++NumCompletedJobs;
+		for (int32 Dependent : Job.Dependents)
+		{
+			if (--Jobs[Dependent].NumPendingPrerequisites == 0)
+			{
+				ReadyJobs.Add(Dependent);
+			}
+		}
+	}
+	for (FEvent* Event : WorkerEvents)
+	{
+		Event->Trigger();
+	}
+	if (WriterEvent)
+	{
+		WriterEvent->Trigger();
+	}
+}
+
+void ns_yoyo::FExportJobGraph::WorkerLoop(int32 WorkerIndex)
+{
+	for (;;)
+	{
+		int32 JobIndex = INDEX_NONE;
+		{
+			FScopeLock ScopeLock(&StateLock);
+			if (NumCompletedJobs == Jobs.Num())
+			{
+				return;
+			}
+			JobIndex = PopReadyJob();
+		}
+		if (JobIndex == INDEX_NONE)
+		{
+			WorkerEvents[WorkerIndex]->Wait();
+			continue;
+		}
+
+		TFunction<void()> Write = Jobs[JobIndex].Convert();
+		// the gathered source isn't needed anymore
+		Jobs[JobIndex].Convert = nullptr;
+		if (!Write)
+		{
+			CompleteJob(JobIndex);
+			continue;
+		}
+		{
+			FScopeLock ScopeLock(&StateLock);
+			FPendingWrite& PendingWrite = PendingWrites.AddDefaulted_GetRef();
+			PendingWrite.JobIndex = JobIndex;
+			PendingWrite.Write = MoveTemp(Write);
+		}
+		WriterEvent->Trigger();
+	}
+}
+
+void ns_yoyo::FExportJobGraph::WriterLoop()
+{
+	for (;;)
+	{
+		FPendingWrite PendingWrite;
+		{
+			FScopeLock ScopeLock(&StateLock);
+			if (PendingWrites.Num() > 0)
+			{
+				PendingWrite = MoveTemp(PendingWrites[0]);
+				PendingWrites.RemoveAt(0);
+			}
+			else if (NumCompletedJobs == Jobs.Num())
+			{
+				return;
+			}
+		}
+		if (PendingWrite.JobIndex == INDEX_NONE)
+		{
+			WriterEvent->Wait();
+			continue;
+		}
+		PendingWrite.Write();
+		// frees the converted resource before its bytes are released
+		PendingWrite.Write = nullptr;
+		CompleteJob(PendingWrite.JobIndex);
+	}
+}
+
+void ns_yoyo::FExportJobGraph::Run(int32 NumThreads, int64 MemoryBudget)
+{
+	Budget = MemoryBudget > 0 ? MemoryBudget : MAX_int64;
+	NumCompletedJobs = 0;
+	BytesInFlight = 0;
+	PeakBytesInFlight = 0;
+	ReadyJobs.Reset();
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		Jobs[JobIndex].NumPendingPrerequisites = Jobs[JobIndex].NumPrerequisites;
+		if (Jobs[JobIndex].NumPrerequisites == 0)
+		{
+			ReadyJobs.Add(JobIndex);
+		}
+	}
+	{
+		// every job has to become ready, a cycle would leave the workers waiting forever
+		TArray<int32> Reachable = ReadyJobs;
+		TArray<int32> NumPending;
+		NumPending.Reserve(Jobs.Num());
+		for (const FJob& Job : Jobs)
+		{
+			NumPending.Add(Job.NumPrerequisites);
+		}
+		for (int32 i = 0; i < Reachable.Num(); ++i)
+		{
+			for (int32 Dependent : Jobs[Reachable[i]].Dependents)
+			{
+				if (--NumPending[Dependent] == 0)
+				{
+					Reachable.Add(Dependent);
+				}
+			}
+		}
+		check(Reachable.Num() == Jobs.Num());
+	}
+	if (Jobs.Num() == 0)
+	{
+		return;
+	}
+
+	if (NumThreads <= 1)
+	{
+		while (ReadyJobs.Num() > 0)
+		{
+			const int32 JobIndex = ReadyJobs[0];
+			ReadyJobs.RemoveAt(0);
+			BytesInFlight = Jobs[JobIndex].EstimatedBytes;
+			PeakBytesInFlight = FMath::Max(PeakBytesInFlight, BytesInFlight);
+			TFunction<void()> Write = Jobs[JobIndex].Convert();
+			Jobs[JobIndex].Convert = nullptr;
+			if (Write)
+			{
+				Write();
+			}
+			CompleteJob(JobIndex);
+		}
+		return;
+	}
+
+	// dedicated threads, workers block on each other and the writer, which tasks must not do
+	for (int32 WorkerIndex = 0; WorkerIndex < NumThreads; ++WorkerIndex)
+	{
+		WorkerEvents.Add(FPlatformProcess::GetSynchEventFromPool(false));
+	}
+	WriterEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	TArray<TFuture<void>> Threads;
+	for (int32 WorkerIndex = 1; WorkerIndex < NumThreads; ++WorkerIndex)
+	{
+		Threads.Add(Async(EAsyncExecution::Thread, [this, WorkerIndex]() { WorkerLoop(WorkerIndex); }));
+	}
+	Threads.Add(Async(EAsyncExecution::Thread, [this]() { WriterLoop(); }));
+	WorkerLoop(0);
+	for (TFuture<void>& Thread : Threads)
+	{
+		Thread.Wait();
+	}
+
+	for (FEvent* Event : WorkerEvents)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(Event);
+	}
+	WorkerEvents.Reset();
+	FPlatformProcess::ReturnSynchEventToPool(WriterEvent);
+	WriterEvent = nullptr;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FEvent;
+
+namespace ns_yoyo
+{
+	/*
+	* Runs export jobs in dependency order within a memory budget.
+	* A job converts its resource on a worker thread and returns the write of it, which runs on
+	* the writer thread while the worker converts the next job, so CPU and disk stay busy together.
+	* A job starts once every prerequisite is written and its estimated bytes fit into what the
+	* jobs in flight leave of the budget, a job larger than the whole budget runs alone.
+	* Its bytes are released when its write is done.
+	*/
+	class FExportJobGraph
+	{
+	public:
+		// returns the write of the converted resource, or an empty function when there is nothing to write
+		using FConvertFunction = TFunction<TFunction<void()>()>;
+
+		~FExportJobGraph();
+
+		int32 AddJob(FConvertFunction Convert, int64 EstimatedBytes = 0);
+
+		// Job starts after Prerequisite is written, the edges must not form a cycle
+		void AddPrerequisite(int32 Job, int32 Prerequisite);
+
+		int32 NumJobs() const { return Jobs.Num(); }
+
+		/*
+		* Runs every job on NumThreads worker threads, the calling thread being one of them, and one
+		* writer thread. NumThreads <= 1 converts and writes on the calling thread alone.
+		* MemoryBudget <= 0 doesn't limit the jobs in flight.
+		*/
+		void Run(int32 NumThreads, int64 MemoryBudget);
+
+		// most estimated bytes in flight at once during the last Run
+		int64 GetPeakBytesInFlight() const { return PeakBytesInFlight; }
+
+	private:
+		struct FJob
+		{
+			FConvertFunction Convert;
+			int64 EstimatedBytes = 0;
+			TArray<int32> Dependents;
+			int32 NumPrerequisites = 0;
+			int32 NumPendingPrerequisites = 0;
+		};
+
+		struct FPendingWrite
+		{
+			int32 JobIndex = INDEX_NONE;
+			TFunction<void()> Write;
+		};
+
+		// the first ready job fitting into the budget, INDEX_NONE when none does, StateLock must be held
+		int32 PopReadyJob();
+		// releases the bytes of the job and readies its dependents
+		void CompleteJob(int32 JobIndex);
+		void WorkerLoop(int32 WorkerIndex);
+		void WriterLoop();
+
+		TArray<FJob> Jobs;
+
+		// state of a Run, guarded by StateLock
+		TArray<int32> ReadyJobs;
+		TArray<FPendingWrite> PendingWrites;
+		int32 NumCompletedJobs = 0;
+		int64 Budget = 0;
+		int64 BytesInFlight = 0;
+		int64 PeakBytesInFlight = 0;
+		FCriticalSection StateLock;
+
+		// auto reset, triggered whenever a job may have become ready or a write was queued
+		TArray<FEvent*> WorkerEvents;
+		FEvent* WriterEvent = nullptr;
+	};
+}
@@ -0,0 +1,266 @@
+#include "ExportManifest.h"
+#include "ExportTypes.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	// version of the manifest file itself, not of the exported resources
+	const uint32 ManifestVersion = 4;
+
+	// the stamp is compared first, the content is only hashed when the file was touched since
+	bool IsFileUnchanged(const FString& Filename, const ns_yoyo::FExportManifest::FFileStamp& Stamp, const FString& Hash)
+	{
+		const ns_yoyo::FExportManifest::FFileStamp CurrentStamp = ns_yoyo::FExportManifest::FFileStamp::Get(Filename);
+		if (CurrentStamp.Size == INDEX_NONE)
+		{
+			return false;
+		}
+		return CurrentStamp == Stamp || ns_yoyo::FExportManifest::HashFile(Filename) == Hash;
+	}
+}
+
+ns_yoyo::FExportManifest::FFileStamp ns_yoyo::FExportManifest::FFileStamp::Get(const FString& Filename)
+{
+	const FFileStatData StatData = IFileManager::Get().GetStatData(*Filename);
+	FFileStamp Stamp;
+	if (StatData.bIsValid && !StatData.bIsDirectory)
+	{
+		Stamp.Size = StatData.FileSize;
+		Stamp.Timestamp = StatData.ModificationTime.GetTicks();
+	}
+	return Stamp;
+}
+
+ns_yoyo::FExportManifest::FExportManifest(const FString& InRootPath, uint32 InSettingsHash, const FString& Name)
+	: RootPath(InRootPath)
+	, ManifestFilename(InRootPath / Name + TEXT(".manifest"))
+	, SettingsHash(InSettingsHash)
+{
+	// an unknown manifest is treated as empty, everything is exported again
+	LoadEntries(ManifestFilename, Entries, &SourceFiles);
+}
+
+bool ns_yoyo::FExportManifest::LoadEntries(const FString& Filename, TMap<FString, FEntry>& OutEntries,
+	TMap<FString, FHashedFile>* OutSourceFiles)
+{
+	TArray<uint8> ByteData;
+	if (!FFileHelper::LoadFileToArray(ByteData, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+	FMemoryReader BytesReader(ByteData);
+	uint32 Version = 0;
+	BytesReader << Version;
+	if (Version != ManifestVersion)
+	{
+		return false;
+	}
+	BytesReader << OutEntries;
+	if (OutSourceFiles)
+	{
+		BytesReader << *OutSourceFiles;
+	}
+	if (BytesReader.IsError())
+	{
+		OutEntries.Empty();
+		if (OutSourceFiles)
+		{
+			OutSourceFiles->Empty();
+		}
+		return false;
+	}
+	return true;
+}
+
+bool ns_yoyo::FExportManifest::IsUpToDate(const FString& ResourcePath, const FString& SourceHash) const
+{
+	FEntry Entry;
+	{
+		FScopeLock ScopeLock(&EntriesLock);
+		const FEntry* Found = Entries.Find(ResourcePath);
+		if (!Found)
+		{
+			return false;
+		}
+		Entry = *Found;
+	}
+	if (SourceHash.IsEmpty()
+		|| Entry.SourceHash != SourceHash
+		|| Entry.FormatVersion != ExportFormatVersion
+		|| Entry.SettingsHash != SettingsHash
+		// the file may have been edited or deleted behind our back
+		|| !IsFileUnchanged(RootPath + ResourcePath, Entry.OutputStamp, Entry.OutputHash))
+	{
+		return false;
+	}
+	// and so may the blobs, named by the md5 of their content
+	for (int32 BlobIndex = 0; BlobIndex < Entry.BlobPaths.Num(); ++BlobIndex)
+	{
+		const FString& BlobPath = Entry.BlobPaths[BlobIndex];
+		const FFileStamp BlobStamp = Entry.BlobStamps.IsValidIndex(BlobIndex) ? Entry.BlobStamps[BlobIndex] : FFileStamp();
+		if (!IsFileUnchanged(RootPath + BlobPath, BlobStamp, FPaths::GetBaseFilename(BlobPath)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ns_yoyo::FExportManifest::Update(const FString& ResourcePath, const FString& PackageName, const FString& SourceHash,
+	const TArray<FString>& BlobPaths)
+{
+	FEntry Entry;
+	Entry.PackageName = PackageName;
+	Entry.SourceHash = SourceHash;
+	Entry.FormatVersion = ExportFormatVersion;
+	Entry.SettingsHash = SettingsHash;
+	// stamped before hashing, so a file written in between doesn't pass for the hashed one
+	Entry.OutputStamp = FFileStamp::Get(RootPath + ResourcePath);
+	Entry.OutputHash = HashFile(RootPath + ResourcePath);
+	Entry.BlobPaths = BlobPaths;
+	for (const FString& BlobPath : BlobPaths)
+	{
+		Entry.BlobStamps.Add(FFileStamp::Get(RootPath + BlobPath));
+	}
+
+	FScopeLock ScopeLock(&EntriesLock);
+	Entries.Add(ResourcePath, MoveTemp(Entry));
+}
+
+int32 ns_yoyo::FExportManifest::RemoveStaleEntries(bool bSweepBlobs)
+{
+	FScopeLock ScopeLock(&EntriesLock);
+	int32 NumRemoved = 0;
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!FPackageName::DoesPackageExist(It.Value().PackageName))
+		{
+			IFileManager::Get().Delete(*(RootPath + It.Key()), false, false, true);
+			It.RemoveCurrent();
+			++NumRemoved;
+		}
+	}
+	for (auto It = SourceFiles.CreateIterator(); It; ++It)
+	{
+		if (!IFileManager::Get().FileExists(*It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+	if (!bSweepBlobs)
+	{
+		return NumRemoved;
+	}
+
+	// the blobs of the root are shared by every manifest in it, those of commandlet shards included
+	TSet<FString> ReferencedBlobs;
+	auto AddReferencedBlobs = [&ReferencedBlobs](const TMap<FString, FEntry>& ManifestEntries)
+	{
+		for (const TPair<FString, FEntry>& Entry : ManifestEntries)
+		{
+			ReferencedBlobs.Append(Entry.Value.BlobPaths);
+		}
+	};
+	AddReferencedBlobs(Entries);
+	TArray<FString> ManifestFiles;
+	IFileManager::Get().FindFiles(ManifestFiles, *(RootPath / TEXT("*.manifest")), true, false);
+	for (const FString& ManifestFile : ManifestFiles)
+	{
+		const FString Filename = RootPath / ManifestFile;
+		if (Filename == ManifestFilename)
+		{
+			continue;
+		}
+		TMap<FString, FEntry> OtherEntries;
+		if (!LoadEntries(Filename, OtherEntries))
+		{
+			// what an unreadable manifest references is unknown, every blob is kept
+			return NumRemoved;
+		}
+		AddReferencedBlobs(OtherEntries);
+	}
+
+	TArray<FString> BlobFiles;
+	IFileManager::Get().FindFiles(BlobFiles, *(RootPath / TEXT("Blobs/*.bin")), true, false);
+	for (const FString& BlobFile : BlobFiles)
+	{
+		if (!ReferencedBlobs.Contains(TEXT("/Blobs/") + BlobFile))
+		{
+			IFileManager::Get().Delete(*(RootPath / TEXT("Blobs") / BlobFile), false, false, true);
+			++NumRemoved;
+		}
+	}
+	return NumRemoved;
+}
+
+int32 ns_yoyo::FExportManifest::RemoveOutdatedEntries(const FString& PackageName, const TSet<FString>& ResourcePaths)
+{
+	FScopeLock ScopeLock(&EntriesLock);
+	int32 NumRemoved = 0;
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (It.Value().PackageName == PackageName && !ResourcePaths.Contains(It.Key()))
+		{
+			IFileManager::Get().Delete(*(RootPath + It.Key()), false, false, true);
+			It.RemoveCurrent();
+			++NumRemoved;
+		}
+	}
+	return NumRemoved;
+}
+
+bool ns_yoyo::FExportManifest::Save()
+{
+	TArray<uint8> ByteData;
+	FMemoryWriter BytesWriter(ByteData);
+	uint32 Version = ManifestVersion;
+	BytesWriter << Version;
+	{
+		FScopeLock ScopeLock(&EntriesLock);
+		BytesWriter << Entries;
+		BytesWriter << SourceFiles;
+	}
+	return FFileHelper::SaveArrayToFile(ByteData, *ManifestFilename);
+}
+
+FString ns_yoyo::FExportManifest::HashSourceFile(const FString& Filename)
+{
+	const FFileStamp Stamp = FFileStamp::Get(Filename);
+	if (Stamp.Size == INDEX_NONE)
+	{
+		return FString();
+	}
+	{
+		FScopeLock ScopeLock(&EntriesLock);
+		const FHashedFile* Found = SourceFiles.Find(Filename);
+		if (Found && Found->Stamp == Stamp)
+		{
+			return Found->Hash;
+		}
+	}
+
+	// stamped before hashing as well, a file written in between is hashed again next time
+	FHashedFile HashedFile;
+	HashedFile.Stamp = Stamp;
+	HashedFile.Hash = HashFile(Filename);
+	if (HashedFile.Hash.IsEmpty())
+	{
+		return FString();
+	}
+	FScopeLock ScopeLock(&EntriesLock);
+	SourceFiles.Add(Filename, HashedFile);
+	return HashedFile.Hash;
+}
+
+FString ns_yoyo::FExportManifest::HashFile(const FString& Filename)
+{
+	FMD5Hash Hash = FMD5Hash::HashFile(*Filename);
+	return Hash.IsValid() ? LexToString(Hash) : FString();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Persistent record of what was exported into an output root.
+	* An asset is skipped when its package, the exporter format version, the export
+	* settings and the file already on disk all match what was recorded on the last export.
+	* Files are only hashed again when their size or modification time changed.
+	*/
+	class FExportManifest
+	{
+	public:
+		// size and modification time of a file, compared before hashing it
+		struct FFileStamp
+		{
+			// INDEX_NONE when there is no file
+			int64 Size = INDEX_NONE;
+			// ticks of the modification time
+			int64 Timestamp = 0;
+
+			static FFileStamp Get(const FString& Filename);
+
+			bool operator==(const FFileStamp& Other) const { return Size == Other.Size && Timestamp == Other.Timestamp; }
+			bool operator!=(const FFileStamp& Other) const { return !(*this == Other); }
+
+			friend FArchive& operator<<(FArchive& Ar, FFileStamp& Stamp)
+			{
+				return Ar << Stamp.Size << Stamp.Timestamp;
+			}
+		};
+
+		struct FEntry
+		{
+			// long package name of the source asset, e.g. /Game/Meshes/Chair
+			FString PackageName;
+			// md5 of the package file the resource was built from
+			FString SourceHash;
+			uint32 FormatVersion = 0;
+			// hash of the export settings the file was written with
+			uint32 SettingsHash = 0;
+			// md5 of the exported file
+			FString OutputHash;
+			FFileStamp OutputStamp;
+			// shared blobs the file references, /Blobs/<md5>.bin
+			TArray<FString> BlobPaths;
+			// one per blob path
+			TArray<FFileStamp> BlobStamps;
+
+			friend FArchive& operator<<(FArchive& Ar, FEntry& Entry)
+			{
+				return Ar << Entry.PackageName
+					<< Entry.SourceHash
+					<< Entry.FormatVersion
+					<< Entry.SettingsHash
+					<< Entry.OutputHash
+					<< Entry.OutputStamp
+					<< Entry.BlobPaths
+					<< Entry.BlobStamps;
+			}
+		};
+
+		// loads the manifest stored in RootPath, if there is one. Exports running side by side
+		// into the same root, like commandlet shards, each keep their own Name
+		FExportManifest(const FString& RootPath, uint32 SettingsHash, const FString& Name = TEXT("AssetExporter"));
+
+		// ResourcePath is relative to the root, as in FStaticMeshResource::Path
+		bool IsUpToDate(const FString& ResourcePath, const FString& SourceHash) const;
+
+		// records a freshly written resource and the blobs it references
+		void Update(const FString& ResourcePath, const FString& PackageName, const FString& SourceHash,
+			const TArray<FString>& BlobPaths = TArray<FString>());
+
+		/*
+		* Deletes exported files whose source package no longer exists and, with bSweepBlobs, the blobs
+		* no manifest of the root references anymore. Returns the number of files removed.
+		* Exports running side by side into the root must not sweep blobs, one may reference
+		* a blob its manifest doesn't record yet.
+		*/
+		int32 RemoveStaleEntries(bool bSweepBlobs = true);
+
+		// deletes the exported files of PackageName that aren't in ResourcePaths, those it no longer
+		// exports into, like the cells of a level split with another cell size. returns the number removed
+		int32 RemoveOutdatedEntries(const FString& PackageName, const TSet<FString>& ResourcePaths);
+
+		bool Save();
+
+		// md5 of a source file, kept with its stamp across exports so an unchanged file is hashed once.
+		// empty when there is no file
+		FString HashSourceFile(const FString& Filename);
+
+		static FString HashFile(const FString& Filename);
+
+	private:
+		struct FHashedFile
+		{
+			FFileStamp Stamp;
+			FString Hash;
+
+			friend FArchive& operator<<(FArchive& Ar, FHashedFile& HashedFile)
+			{
+				return Ar << HashedFile.Stamp << HashedFile.Hash;
+			}
+		};
+
+		// the source files are only read into OutSourceFiles when given
+		static bool LoadEntries(const FString& Filename, TMap<FString, FEntry>& OutEntries,
+			TMap<FString, FHashedFile>* OutSourceFiles = nullptr);
+
+		FString RootPath;
+		FString ManifestFilename;
+		uint32 SettingsHash;
+		// keyed by resource path
+		TMap<FString, FEntry> Entries;
+		// keyed by filename
+		TMap<FString, FHashedFile> SourceFiles;
+		// guards Entries and SourceFiles
+		mutable FCriticalSection EntriesLock;
+	};
+}
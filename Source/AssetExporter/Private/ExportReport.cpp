@@ -0,0 +1,223 @@
+#include "ExportReport.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+	const TCHAR* StageNames[] = {
+		TEXT("Gather"),
+		TEXT("VertexBuffer"),
+		TEXT("IndexBuffer"),
+		TEXT("SkinWeights"),
+		TEXT("Optimize"),
+		TEXT("Meshlets"),
+		TEXT("Animation"),
+		TEXT("AnimSampling"),
+		TEXT("AnimCompression"),
+		TEXT("VertexAnimation"),
+		TEXT("Texture"),
+		TEXT("SceneBVH"),
+		TEXT("Write"),
+		TEXT("Manifest"),
+	};
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)ns_yoyo::EExportStage::Max, "StageNames out of date");
+
+	const TCHAR* GetResourceTypeName(ns_yoyo::EResourceType Type)
+	{
+		switch (Type)
+		{
+		case ns_yoyo::EResourceType::Level:
+			return TEXT("Level");
+		case ns_yoyo::EResourceType::StaticMesh:
+			return TEXT("StaticMesh");
+		case ns_yoyo::EResourceType::SkeletalMesh:
+			return TEXT("SkeletalMesh");
+		case ns_yoyo::EResourceType::AnimSequence:
+			return TEXT("AnimSequence");
+		case ns_yoyo::EResourceType::Skeleton:
+			return TEXT("Skeleton");
+		case ns_yoyo::EResourceType::VertexAnimation:
+			return TEXT("VertexAnimation");
+		case ns_yoyo::EResourceType::Texture:
+			return TEXT("Texture");
+		case ns_yoyo::EResourceType::Max:
+		default:
+			return TEXT("Unknown");
+		}
+	}
+
+	double ToMB(uint64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	// quoted when it holds a separator, quote or line break, quotes doubled
+	FString EscapeCsv(const FString& Value)
+	{
+		int32 Index;
+		if (!Value.FindChar(TEXT(','), Index) && !Value.FindChar(TEXT('"'), Index)
+			&& !Value.FindChar(TEXT('\n'), Index) && !Value.FindChar(TEXT('\r'), Index))
+		{
+			return Value;
+		}
+		return TEXT("\"") + Value.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+	}
+
+	using FJsonWriter = TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>;
+
+	void WriteStageSeconds(FJsonWriter& Writer, const double* StageSeconds)
+	{
+		Writer.WriteObjectStart(TEXT("StageSeconds"));
+		for (int32 Stage = 0; Stage < (int32)ns_yoyo::EExportStage::Max; ++Stage)
+		{
+			Writer.WriteValue(StageNames[Stage], StageSeconds[Stage]);
+		}
+		Writer.WriteObjectEnd();
+	}
+}
+
+const TCHAR* ns_yoyo::GetExportStageName(EExportStage Stage)
+{
+	check(Stage < EExportStage::Max);
+	return StageNames[(int32)Stage];
+}
+
+double ns_yoyo::FAssetExportRecord::GetTotalSeconds() const
+{
+	double Total = 0.0;
+	for (double Seconds : StageSeconds)
+	{
+		Total += Seconds;
+	}
+	return Total;
+}
+
+ns_yoyo::FExportReport::FExportReport()
+	: StartTime(FPlatformTime::Seconds())
+{
+}
+
+ns_yoyo::FAssetExportRecord* ns_yoyo::FExportReport::AddAsset(const FString& Path, EResourceType Type)
+{
+	TUniquePtr<FAssetExportRecord> Record = MakeUnique<FAssetExportRecord>();
+	Record->Path = Path;
+	Record->Type = Type;
+	FAssetExportRecord* Result = Record.Get();
+	FScopeLock ScopeLock(&RecordsLock);
+	Records.Add(MoveTemp(Record));
+	return Result;
+}
+
+bool ns_yoyo::FExportReport::Save(const FString& BasePath, int32 NumSlowest) const
+{
+	FScopeLock ScopeLock(&RecordsLock);
+
+	FAssetExportRecord Totals;
+	int32 NumSkipped = 0;
+	for (const TUniquePtr<FAssetExportRecord>& Record : Records)
+	{
+		NumSkipped += Record->bSkipped ? 1 : 0;
+		Totals.BytesWritten += Record->BytesWritten;
+		Totals.NumVertices += Record->NumVertices;
+		Totals.NumTriangles += Record->NumTriangles;
+		for (int32 Stage = 0; Stage < (int32)EExportStage::Max; ++Stage)
+		{
+			Totals.StageSeconds[Stage] += Record->StageSeconds[Stage];
+		}
+	}
+
+	TArray<const FAssetExportRecord*> Slowest;
+	for (const TUniquePtr<FAssetExportRecord>& Record : Records)
+	{
+		Slowest.Add(Record.Get());
+	}
+	Slowest.Sort([](const FAssetExportRecord& A, const FAssetExportRecord& B) { return A.GetTotalSeconds() > B.GetTotalSeconds(); });
+	Slowest.SetNum(FMath::Min(Slowest.Num(), NumSlowest));
+
+	// json
+	FString Json;
+	TSharedRef<FJsonWriter> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("WallSeconds"), FPlatformTime::Seconds() - StartTime);
+	Writer->WriteValue(TEXT("ProcessPeakUsedPhysicalMB"), ToMB(FPlatformMemory::GetStats().PeakUsedPhysical));
+
+	Writer->WriteObjectStart(TEXT("Totals"));
+	Writer->WriteValue(TEXT("Assets"), Records.Num());
+	Writer->WriteValue(TEXT("Skipped"), NumSkipped);
+	Writer->WriteValue(TEXT("BytesWritten"), (int64)Totals.BytesWritten);
+	Writer->WriteValue(TEXT("Vertices"), (int64)Totals.NumVertices);
+	Writer->WriteValue(TEXT("Triangles"), (int64)Totals.NumTriangles);
+	WriteStageSeconds(*Writer, Totals.StageSeconds);
+	Writer->WriteObjectEnd();
+
+	Writer->WriteArrayStart(TEXT("Slowest"));
+	for (const FAssetExportRecord* Record : Slowest)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Path"), Record->Path);
+		Writer->WriteValue(TEXT("TotalSeconds"), Record->GetTotalSeconds());
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteArrayStart(TEXT("Assets"));
+	for (const TUniquePtr<FAssetExportRecord>& Record : Records)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Path"), Record->Path);
+		Writer->WriteValue(TEXT("Type"), GetResourceTypeName(Record->Type));
+		Writer->WriteValue(TEXT("Skipped"), Record->bSkipped);
+		Writer->WriteValue(TEXT("BytesWritten"), (int64)Record->BytesWritten);
+		Writer->WriteValue(TEXT("Vertices"), (int64)Record->NumVertices);
+		Writer->WriteValue(TEXT("Triangles"), (int64)Record->NumTriangles);
+		Writer->WriteValue(TEXT("ProcessPeakUsedPhysicalMB"), ToMB(Record->PeakUsedPhysical));
+		Writer->WriteValue(TEXT("TotalSeconds"), Record->GetTotalSeconds());
+		WriteStageSeconds(*Writer, Record->StageSeconds);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	// csv, one row per asset. the peak is the whole process's while the asset was exported,
+	// assets built in parallel share it
+	FString Csv = TEXT("Path,Type,Skipped,BytesWritten,Vertices,Triangles,ProcessPeakUsedPhysicalMB,TotalSeconds");
+	for (const TCHAR* StageName : StageNames)
+	{
+		Csv += FString::Printf(TEXT(",%sSeconds"), StageName);
+	}
+	Csv += LINE_TERMINATOR;
+	for (const TUniquePtr<FAssetExportRecord>& Record : Records)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%d,%llu,%u,%u,%.1f,%.6f"), *EscapeCsv(Record->Path), GetResourceTypeName(Record->Type),
+			Record->bSkipped, Record->BytesWritten, Record->NumVertices, Record->NumTriangles,
+			ToMB(Record->PeakUsedPhysical), Record->GetTotalSeconds());
+		for (double Seconds : Record->StageSeconds)
+		{
+			Csv += FString::Printf(TEXT(",%.6f"), Seconds);
+		}
+		Csv += LINE_TERMINATOR;
+	}
+
+	return FFileHelper::SaveStringToFile(Json, *(BasePath + TEXT(".json")))
+		&& FFileHelper::SaveStringToFile(Csv, *(BasePath + TEXT(".csv")));
+}
+
+ns_yoyo::FExportStageScope::FExportStageScope(FAssetExportRecord* InRecord, EExportStage InStage)
+	: Record(InRecord)
+	, Stage(InStage)
+	, StartTime(Record ? FPlatformTime::Seconds() : 0.0)
+{
+}
+
+ns_yoyo::FExportStageScope::~FExportStageScope()
+{
+	if (Record)
+	{
+		Record->StageSeconds[(int32)Stage] += FPlatformTime::Seconds() - StartTime;
+		Record->PeakUsedPhysical = FMath::Max<uint64>(Record->PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	enum class EExportStage : uint8
+	{
+		Gather,
+		VertexBuffer,
+		IndexBuffer,
+		SkinWeights,
+		Optimize,
+		// meshlet split with bounds and normal cones
+		Meshlets,
+		Animation,
+		// resampling and matrix baking
+		AnimSampling,
+		AnimCompression,
+		// offline skinning of vertex animations
+		VertexAnimation,
+		// mip loading and transcoding of textures
+		Texture,
+		// the BVH over the instances of a scene
+		SceneBVH,
+		// serialization, streamed straight into the file
+		Write,
+		// source and output hashing of the incremental export
+		Manifest,
+		Max
+	};
+
+	const TCHAR* GetExportStageName(EExportStage Stage);
+
+	// what exporting one asset cost, filled by the thread exporting it
+	struct FAssetExportRecord
+	{
+		FString Path;
+		EResourceType Type = EResourceType::Max;
+		// up to date in the manifest, nothing was built
+		bool bSkipped = false;
+		uint64 BytesWritten = 0;
+		uint32 NumVertices = 0;
+		uint32 NumTriangles = 0;
+		double StageSeconds[(int32)EExportStage::Max] = {};
+		// process wide, sampled at the end of every stage of this asset
+		uint64 PeakUsedPhysical = 0;
+
+		double GetTotalSeconds() const;
+	};
+
+	/*
+	* Per run report of every exported asset, saved as <BasePath>.json and <BasePath>.csv
+	* with totals and the slowest assets. Records may be added from any thread.
+	*/
+	class FExportReport
+	{
+	public:
+		FExportReport();
+
+		// the record stays valid for the lifetime of the report
+		FAssetExportRecord* AddAsset(const FString& Path, EResourceType Type);
+
+		bool Save(const FString& BasePath, int32 NumSlowest) const;
+
+	private:
+		double StartTime;
+		TArray<TUniquePtr<FAssetExportRecord>> Records;
+		mutable FCriticalSection RecordsLock;
+	};
+
+	// adds the time until the end of the scope to a stage of Record, if there is one
+	class FExportStageScope
+	{
+	public:
+		FExportStageScope(FAssetExportRecord* Record, EExportStage Stage);
+		~FExportStageScope();
+
+	private:
+		FAssetExportRecord* Record;
+		EExportStage Stage;
+		double StartTime;
+	};
+}
+
+// times a stage into the report and marks it in Unreal Insights
+#define EXPORT_STAGE_SCOPE(Record, Stage) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(AssetExporter_##Stage); \
+	ns_yoyo::FExportStageScope PREPROCESSOR_JOIN(ExportStageScope, __LINE__)(Record, ns_yoyo::EExportStage::Stage)
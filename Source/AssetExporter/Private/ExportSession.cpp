@@ -0,0 +1,97 @@
+#include "ExportSession.h"
+#include "HAL/FileManager.h"
+#include "Misc/Guid.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+namespace
+{
+	// written under a unique temp name and renamed, shards running side by side may write the same blob
+	bool WriteBlobFile(const FString& Filename, const void* Data, int64 Size)
+	{
+		const FString TempFilename = Filename + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+		TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*TempFilename));
+		if (!FileWriter)
+		{
+			return false;
+		}
+		FileWriter->Serialize(const_cast<void*>(Data), Size);
+		bool bOk = FileWriter->Close();
+		FileWriter.Reset();
+		if (bOk)
+		{
+			bOk = IFileManager::Get().Move(*Filename, *TempFilename, true, true);
+		}
+		if (!bOk)
+		{
+			IFileManager::Get().Delete(*TempFilename, false, false, true);
+		}
+		return bOk;
+	}
+}
+
+ns_yoyo::FExportSession::FExportSession(const FString& InOutPath, uint32 SettingsHash, const FString& ManifestName, bool bReport)
+	: OutPath(InOutPath)
+	, Manifest(InOutPath, SettingsHash, ManifestName)
+{
+	if (bReport)
+	{
+		Report.Emplace();
+	}
+}
+
+bool ns_yoyo::FExportSession::ClaimResource(const FString& ResourcePath, const FString& SourceHash)
+{
+	if (SourceHash.IsEmpty())
+	{
+		return true;
+	}
+	FScopeLock ScopeLock(&ResourcesLock);
+	FString* Found = Resources.Find(ResourcePath);
+	if (Found && *Found == SourceHash)
+	{
+		++NumSharedResources;
+		return false;
+	}
+	// a package saved again since its last export in this session is exported again
+	Resources.Add(ResourcePath, SourceHash);
+	return true;
+}
+
+FString ns_yoyo::FExportSession::WriteBlob(const void* Data, int64 Size)
+{
+	FMD5 Md5;
+	Md5.Update(static_cast<const uint8*>(Data), Size);
+	FMD5Hash Hash;
+	Hash.Set(Md5);
+	const FString BlobPath = FString::Printf(TEXT("/Blobs/%s.bin"), *LexToString(Hash));
+	{
+		FScopeLock ScopeLock(&BlobsLock);
+		if (Blobs.Contains(BlobPath))
+		{
+			++NumSharedBlobs;
+			SharedBlobBytes += Size;
+			return BlobPath;
+		}
+	}
+
+	// the name is the content, a blob left by an earlier session is reused as is. jobs writing the
+	// same blob at once each write their own temp file, the blob is only handed out once it is in place
+	const FString Filename = OutPath + BlobPath;
+	if (IFileManager::Get().FileSize(*Filename) != Size)
+	{
+		bool bOk = WriteBlobFile(Filename, Data, Size);
+		check(bOk);
+	}
+	FScopeLock ScopeLock(&BlobsLock);
+	Blobs.Add(BlobPath);
+	return BlobPath;
+}
+
+void ns_yoyo::FExportSession::LogStats() const
+{
+	FScopeLock ResourcesScopeLock(&ResourcesLock);
+	FScopeLock BlobsScopeLock(&BlobsLock);
+	UE_LOG(LogTemp, Log, TEXT("Export session %s: %d resources, %d requested again; %d blobs, %d shared saving %.1f MB"),
+		*OutPath, Resources.Num(), NumSharedResources, Blobs.Num(), NumSharedBlobs, SharedBlobBytes / (1024.0 * 1024.0));
+}
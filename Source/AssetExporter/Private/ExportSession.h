@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportManifest.h"
+#include "ExportReport.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Everything exports into one output root share, from the first asset to the last across
+	* ExportAsset/ExportAssets/ExportMap calls:
+	* - the manifest and the optional report
+	* - a registry of the resources written so far, keyed by resource path and source package hash,
+	*   so an asset requested again, or a skeleton every mesh and animation depends on, is built once
+	* - content addressed blobs, identical vertex/index data of different assets is written once
+	* Every method may be called from export jobs running in parallel.
+	*/
+	class FExportSession
+	{
+	public:
+		FExportSession(const FString& OutPath, uint32 SettingsHash, const FString& ManifestName = TEXT("AssetExporter"),
+			bool bReport = false);
+
+		const FString& GetOutPath() const { return OutPath; }
+		FExportManifest& GetManifest() { return Manifest; }
+		FExportReport* GetReport() { return Report.GetPtrOrNull(); }
+
+		// true for the first claim of ResourcePath built from SourceHash, the caller then builds and writes it.
+		// always true without a SourceHash, there is nothing to tell two versions of the source apart
+		bool ClaimResource(const FString& ResourcePath, const FString& SourceHash);
+
+		/*
+		* Writes Data to /Blobs/<md5>.bin under the output root, unless this or an earlier session
+		* already did, and returns that path. The manifest records the blobs of every resource,
+		* RemoveStaleEntries deletes those no resource references anymore.
+		*/
+		FString WriteBlob(const void* Data, int64 Size);
+
+		// logs how many resources and blobs were written and shared
+		void LogStats() const;
+
+	private:
+		FString OutPath;
+		FExportManifest Manifest;
+		TOptional<FExportReport> Report;
+
+		// source hash every resource was exported from
+		TMap<FString, FString> Resources;
+		int32 NumSharedResources = 0;
+		mutable FCriticalSection ResourcesLock;
+
+		TSet<FString> Blobs;
+		int32 NumSharedBlobs = 0;
+		int64 SharedBlobBytes = 0;
+		mutable FCriticalSection BlobsLock;
+	};
+}
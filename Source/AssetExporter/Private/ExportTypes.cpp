@@ -1,6 +1,10 @@
 
 #include "ExportTypes.h"
+#include "Math/Float16.h"
+#include "Rendering/PositionVertexBuffer.h"
+#include "Rendering/SkinWeightVertexBuffer.h"
 #include "Rendering/StaticMeshVertexBuffer.h"
+#include "StaticMeshResources.h"
 
 /*
 * code example
@@ -11,41 +15,585 @@ auto package_file = FPackageName::LongPackageNameToFilename(Mesh->GetPackage()->
 package_path.ReplaceInline(TEXT("/Game"), TEXT(""));
 */
 
-void ns_yoyo::ExportVertexBuffer(FVertexBuffer& VertexBuffer, FStaticMeshVertexBuffers& VertexBuffers)
+namespace
 {
+	/*
+	* Interleaves position, normal and uv0 of every vertex straight from the UE streams.
+	* The packed tangent and uv formats are fixed per buffer, so they are resolved once
+	* here instead of on every VertexTangentZ/GetVertexUV call.
+	*/
+	template<EStaticMeshVertexTangentBasisType TangentBasisType, EStaticMeshVertexUVType UVType>
+	void InterleaveVertices(float* RESTRICT Dest, FStaticMeshVertexBuffers& VertexBuffers)
+	{
+		using FTangentDatum = TStaticMeshVertexTangentDatum<typename TStaticMeshVertexTangentTypeSelector<TangentBasisType>::TangentTypeT>;
+		using FUVDatum = TStaticMeshVertexUVsDatum<typename TStaticMeshVertexUVsTypeSelector<UVType>::UVsTypeT>;
+
+		const uint32 NumVertices = VertexBuffers.PositionVertexBuffer.GetNumVertices();
+		const uint32 NumTexCoords = VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords();
+		const FVector* RESTRICT Positions = static_cast<const FVector*>(VertexBuffers.PositionVertexBuffer.GetVertexData());
+		const FTangentDatum* RESTRICT Tangents = static_cast<const FTangentDatum*>(VertexBuffers.StaticMeshVertexBuffer.GetTangentData());
+		const FUVDatum* RESTRICT UVs = static_cast<const FUVDatum*>(VertexBuffers.StaticMeshVertexBuffer.GetTexCoordData());
+
+		for (uint32 i = 0; i < NumVertices; ++i, Dest += 8)
+		{
+			// same decode as VertexTangentZ/GetVertexUV, so the output is bit identical
+			const FVector4 Normal = Tangents[i].GetTangentZ();
+			const FVector2D UV = UVs[i * NumTexCoords].GetUV();
+
+			const VectorRegister PositionReg = VectorLoadFloat3(&Positions[i]);
+			const VectorRegister NormalReg = VectorLoad(&Normal);
+			const VectorRegister UVReg = VectorLoadFloat2(&UV);
+			// (pz, pz, nx, nx)
+			const VectorRegister Mixed = VectorShuffle(PositionReg, NormalReg, 2, 2, 0, 0);
+			// (px, py, pz, nx) (ny, nz, u, v)
+			VectorStore(VectorShuffle(PositionReg, Mixed, 0, 1, 0, 2), Dest);
+			VectorStore(VectorShuffle(NormalReg, UVReg, 1, 2, 0, 1), Dest + 4);
+		}
+	}
+
+	const TCHAR* AttributeNames[] = { TEXT("Position"), TEXT("Normal"), TEXT("Tangent"), TEXT("Color"), TEXT("TexCoord") };
+	static_assert(UE_ARRAY_COUNT(AttributeNames) == (int32)ns_yoyo::EVertexAttribute::Max, "AttributeNames out of date");
+
+	const TCHAR* EncodingNames[] = { TEXT("Float2"), TEXT("Float3"), TEXT("Float4"), TEXT("Half2"), TEXT("Oct16"), TEXT("Quantized16"), TEXT("RGBA8") };
+	static_assert(UE_ARRAY_COUNT(EncodingNames) == (int32)ns_yoyo::EVertexEncoding::Max, "EncodingNames out of date");
+
+	uint32 GetEncodingSize(ns_yoyo::EVertexEncoding Encoding)
+	{
+		switch (Encoding)
+		{
+		case ns_yoyo::EVertexEncoding::Float2: return 8;
+		case ns_yoyo::EVertexEncoding::Float3: return 12;
+		case ns_yoyo::EVertexEncoding::Float4: return 16;
+		case ns_yoyo::EVertexEncoding::Half2: return 4;
+		case ns_yoyo::EVertexEncoding::Oct16: return 4;
+		case ns_yoyo::EVertexEncoding::Quantized16: return 8;
+		case ns_yoyo::EVertexEncoding::RGBA8: return 4;
+		case ns_yoyo::EVertexEncoding::Max:
+		default:
+			check(false);
+			return 0;
+		}
+	}
+
+	bool IsEncodingAllowed(ns_yoyo::EVertexAttribute Attribute, ns_yoyo::EVertexEncoding Encoding)
+	{
+		using namespace ns_yoyo;
+		switch (Attribute)
+		{
+		case EVertexAttribute::Position:
+			return Encoding == EVertexEncoding::Float3 || Encoding == EVertexEncoding::Quantized16;
+		case EVertexAttribute::Normal:
+			return Encoding == EVertexEncoding::Float3 || Encoding == EVertexEncoding::Oct16;
+		case EVertexAttribute::Tangent:
+			return Encoding == EVertexEncoding::Float4 || Encoding == EVertexEncoding::Oct16;
+		case EVertexAttribute::Color:
+			return Encoding == EVertexEncoding::Float4 || Encoding == EVertexEncoding::RGBA8;
+		case EVertexAttribute::TexCoord:
+			return Encoding == EVertexEncoding::Float2 || Encoding == EVertexEncoding::Half2;
+		default:
+			return false;
+		}
+	}
+
+	int16 ToSNorm16(float Value)
+	{
+		return (int16)FMath::RoundToInt(FMath::Clamp(Value, -1.f, 1.f) * 32767.f);
+	}
+
+	// octahedral mapping of a unit vector to [-1, 1]^2
+	FVector2D OctEncode(const FVector& N)
+	{
+		const float L1Norm = FMath::Abs(N.X) + FMath::Abs(N.Y) + FMath::Abs(N.Z);
+		if (L1Norm <= SMALL_NUMBER)
+		{
+			return FVector2D(0.f, 0.f);
+		}
+		FVector2D Oct(N.X / L1Norm, N.Y / L1Norm);
+		if (N.Z < 0.f)
+		{
+			Oct = FVector2D(
+				(1.f - FMath::Abs(Oct.Y)) * (Oct.X >= 0.f ? 1.f : -1.f),
+				(1.f - FMath::Abs(Oct.X)) * (Oct.Y >= 0.f ? 1.f : -1.f));
+		}
+		return Oct;
+	}
+
+	// inverse of OctEncode
+	FVector OctDecode(const FVector2D& Oct)
+	{
+		FVector N(Oct.X, Oct.Y, 1.f - FMath::Abs(Oct.X) - FMath::Abs(Oct.Y));
+		if (N.Z < 0.f)
+		{
+			N.X = (1.f - FMath::Abs(Oct.Y)) * (Oct.X >= 0.f ? 1.f : -1.f);
+			N.Y = (1.f - FMath::Abs(Oct.X)) * (Oct.Y >= 0.f ? 1.f : -1.f);
+		}
+		return N.GetSafeNormal();
+	}
+
+	struct FEncodeContext
+	{
+		FVector PositionOffset;
+		FVector InvPositionScale;
+	};
+
+	// writes Value at Dest in the element's encoding
+	void EncodeValue(uint8* Dest, const ns_yoyo::FVertexElement& Element, const FVector4& Value, const FEncodeContext& Context)
+	{
+		using namespace ns_yoyo;
+		switch (Element.Encoding)
+		{
+		case EVertexEncoding::Float2:
+		case EVertexEncoding::Float3:
+		case EVertexEncoding::Float4:
+			FMemory::Memcpy(Dest, &Value, GetEncodingSize(Element.Encoding));
+			break;
+		case EVertexEncoding::Half2:
+		{
+			const FFloat16 Half[2] = { FFloat16(Value.X), FFloat16(Value.Y) };
+			FMemory::Memcpy(Dest, Half, sizeof(Half));
+			break;
+		}
+		case EVertexEncoding::Oct16:
+		{
+			const FVector2D Oct = OctEncode(FVector(Value.X, Value.Y, Value.Z));
+			int16 SNorm[2] = { ToSNorm16(Oct.X), ToSNorm16(Oct.Y) };
+			if (Element.Attribute == EVertexAttribute::Tangent)
+			{
+				SNorm[1] = (int16)((SNorm[1] & ~1) | (Value.W < 0.f ? 1 : 0));
+			}
+			FMemory::Memcpy(Dest, SNorm, sizeof(SNorm));
+			break;
+		}
+		case EVertexEncoding::Quantized16:
+		{
+			const FVector Normalized = (FVector(Value.X, Value.Y, Value.Z) - Context.PositionOffset) * Context.InvPositionScale;
+			const uint16 Quantized[4] = {
+				(uint16)FMath::Clamp(FMath::RoundToInt(Normalized.X), 0, 65535),
+				(uint16)FMath::Clamp(FMath::RoundToInt(Normalized.Y), 0, 65535),
+				(uint16)FMath::Clamp(FMath::RoundToInt(Normalized.Z), 0, 65535),
+				0 };
+			FMemory::Memcpy(Dest, Quantized, sizeof(Quantized));
+			break;
+		}
+		case EVertexEncoding::RGBA8:
+		{
+			const uint8 RGBA[4] = {
+				(uint8)FMath::RoundToInt(Value.X * 255.f),
+				(uint8)FMath::RoundToInt(Value.Y * 255.f),
+				(uint8)FMath::RoundToInt(Value.Z * 255.f),
+				(uint8)FMath::RoundToInt(Value.W * 255.f) };
+			FMemory::Memcpy(Dest, RGBA, sizeof(RGBA));
+			break;
+		}
+		default:
+			check(false);
+			break;
+		}
+	}
+
+	// writes one element of every vertex, generic path for any layout
+	void WriteElement(uint8* Dest, uint32 Stride, const ns_yoyo::FVertexElement& Element,
+		FStaticMeshVertexBuffers& VertexBuffers, const FEncodeContext& Context)
+	{
+		using namespace ns_yoyo;
+		const uint32 NumVertices = VertexBuffers.PositionVertexBuffer.GetNumVertices();
+		const FStaticMeshVertexBuffer& StaticMeshVertexBuffer = VertexBuffers.StaticMeshVertexBuffer;
+		const bool bHasColors = VertexBuffers.ColorVertexBuffer.GetNumVertices() == NumVertices;
+		const bool bHasTexCoord = Element.Index < StaticMeshVertexBuffer.GetNumTexCoords();
+
+		Dest += Element.Offset;
+		for (uint32 i = 0; i < NumVertices; ++i, Dest += Stride)
+		{
+			FVector4 Value(0.f, 0.f, 0.f, 0.f);
+			switch (Element.Attribute)
+			{
+			case EVertexAttribute::Position:
+				Value = FVector4(VertexBuffers.PositionVertexBuffer.VertexPosition(i), 1.f);
+				break;
+			case EVertexAttribute::Normal:
+				Value = StaticMeshVertexBuffer.VertexTangentZ(i);
+				break;
+			case EVertexAttribute::Tangent:
+				Value = FVector4(FVector(StaticMeshVertexBuffer.VertexTangentX(i)), StaticMeshVertexBuffer.VertexTangentZ(i).W);
+				break;
+			case EVertexAttribute::Color:
+			{
+				const FColor Color = bHasColors ? VertexBuffers.ColorVertexBuffer.VertexColor(i) : FColor::White;
+				Value = FVector4(Color.R / 255.f, Color.G / 255.f, Color.B / 255.f, Color.A / 255.f);
+				break;
+			}
+			case EVertexAttribute::TexCoord:
+				if (bHasTexCoord)
+				{
+					const FVector2D UV = StaticMeshVertexBuffer.GetVertexUV(i, Element.Index);
+					Value = FVector4(UV.X, UV.Y, 0.f, 0.f);
+				}
+				break;
+			default:
+				check(false);
+				break;
+			}
+			EncodeValue(Dest, Element, Value, Context);
+		}
+	}
+
+	// scales Weights to sum to 255, the rounding error goes to the heaviest
+	void RenormalizeWeights(uint8* Weights, uint32 NumWeights)
+	{
+		uint32 Sum = 0;
+		uint32 Heaviest = 0;
+		for (uint32 i = 0; i < NumWeights; ++i)
+		{
+			Sum += Weights[i];
+			Heaviest = Weights[i] > Weights[Heaviest] ? i : Heaviest;
+		}
+		if (Sum == 0 || Sum == 255)
+		{
+			return;
+		}
+		int32 Total = 0;
+		for (uint32 i = 0; i < NumWeights; ++i)
+		{
+			Weights[i] = (uint8)((Weights[i] * 255 + Sum / 2) / Sum);
+			Total += Weights[i];
+		}
+		Weights[Heaviest] = (uint8)FMath::Clamp<int32>(Weights[Heaviest] + 255 - Total, 0, 255);
+	}
+}
+
+uint32 ns_yoyo::FVertexLayout::GetStride() const
+{
+	uint32 Stride = 0;
+	for (const FVertexElement& Element : Elements)
+	{
+		Stride = FMath::Max(Stride, Element.Offset + GetEncodingSize(Element.Encoding));
+	}
+	return Stride;
+}
+
+ns_yoyo::FVertexLayout ns_yoyo::FVertexLayout::Default()
+{
+	FVertexLayout Layout;
+	bool bOk = Parse(TEXT("Position=Float3 Normal=Float3 TexCoord0=Float2"), Layout);
+	check(bOk);
+	return Layout;
+}
+
+bool ns_yoyo::FVertexLayout::Parse(const FString& Desc, FVertexLayout& OutLayout)
+{
+	TArray<FString> Tokens;
+	Desc.ParseIntoArrayWS(Tokens);
+
+	FVertexLayout Layout;
+	uint32 Offset = 0;
+	for (const FString& Token : Tokens)
+	{
+		FString AttributeName;
+		FString EncodingName;
+		if (!Token.Split(TEXT("="), &AttributeName, &EncodingName))
+		{
+			return false;
+		}
+
+		FVertexElement Element;
+		Element.Attribute = EVertexAttribute::Max;
+		Element.Encoding = EVertexEncoding::Max;
+		const FString TexCoordName = AttributeNames[(int32)EVertexAttribute::TexCoord];
+		if (AttributeName.StartsWith(TexCoordName))
+		{
+			const FString Channel = AttributeName.RightChop(TexCoordName.Len());
+			if (Channel.IsEmpty() || !Channel.IsNumeric() || FCString::Atoi(*Channel) >= MAX_STATIC_TEXCOORDS)
+			{
+				return false;
+			}
+			Element.Attribute = EVertexAttribute::TexCoord;
+			Element.Index = (uint8)FCString::Atoi(*Channel);
+		}
+		for (int32 i = 0; i < (int32)EVertexAttribute::TexCoord; ++i)
+		{
+			if (AttributeName == AttributeNames[i])
+			{
+				Element.Attribute = (EVertexAttribute)i;
+			}
+		}
+		for (int32 i = 0; i < (int32)EVertexEncoding::Max; ++i)
+		{
+			if (EncodingName == EncodingNames[i])
+			{
+				Element.Encoding = (EVertexEncoding)i;
+			}
+		}
+		if (Element.Attribute == EVertexAttribute::Max
+			|| Element.Encoding == EVertexEncoding::Max
+			|| !IsEncodingAllowed(Element.Attribute, Element.Encoding))
+		{
+			return false;
+		}
+
+		Element.Offset = (uint8)Offset;
+		Offset += GetEncodingSize(Element.Encoding);
+		if (Offset > MAX_uint8)
+		{
+			return false;
+		}
+		Layout.Elements.Add(Element);
+	}
+	if (Layout.Elements.Num() == 0)
+	{
+		return false;
+	}
+	OutLayout = MoveTemp(Layout);
+	return true;
+}
+
+void ns_yoyo::ExportVertexBuffer(FVertexBuffer& VertexBuffer, FStaticMeshVertexBuffers& VertexBuffers, const FVertexLayout& Layout)
+{
+	VertexBuffer.Layout = Layout;
 	VertexBuffer.NumVertices = VertexBuffers.PositionVertexBuffer.GetNumVertices();
-	VertexBuffer.Stride = 32; // bytes
-	auto& FloatRawData = VertexBuffer.RawData;
-	for (uint32 i = 0; i < VertexBuffer.NumVertices; ++i)
+	VertexBuffer.Stride = Layout.GetStride(); // bytes
+	VertexBuffer.RawData.SetNumUninitialized(VertexBuffer.NumVertices * VertexBuffer.Stride);
+	if (VertexBuffer.NumVertices == 0)
+	{
+		return;
+	}
+
+	if (Layout == FVertexLayout::Default())
+	{
+		// position, normal, uv
+		check(VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords() > 0);
+		float* Dest = reinterpret_cast<float*>(VertexBuffer.RawData.GetData());
+		const bool bHighPrecisionTangents = VertexBuffers.StaticMeshVertexBuffer.GetUseHighPrecisionTangentBasis();
+		const bool bFullPrecisionUVs = VertexBuffers.StaticMeshVertexBuffer.GetUseFullPrecisionUVs();
+		if (bHighPrecisionTangents)
+		{
+			if (bFullPrecisionUVs)
+			{
+				InterleaveVertices<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::HighPrecision>(Dest, VertexBuffers);
+			}
+			else
+			{
+				InterleaveVertices<EStaticMeshVertexTangentBasisType::HighPrecision, EStaticMeshVertexUVType::Default>(Dest, VertexBuffers);
+			}
+		}
+		else
+		{
+			if (bFullPrecisionUVs)
+			{
+				InterleaveVertices<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::HighPrecision>(Dest, VertexBuffers);
+			}
+			else
+			{
+				InterleaveVertices<EStaticMeshVertexTangentBasisType::Default, EStaticMeshVertexUVType::Default>(Dest, VertexBuffers);
+			}
+		}
+		return;
+	}
+
+	// per mesh bounds for quantized positions
+	VertexBuffer.PositionOffset = FVector::ZeroVector;
+	VertexBuffer.PositionScale = FVector::OneVector;
+	FEncodeContext Context;
+	const bool bQuantizedPositions = Layout.Elements.ContainsByPredicate([](const FVertexElement& Element)
+	{
+		return Element.Encoding == EVertexEncoding::Quantized16;
+	});
+	if (bQuantizedPositions)
+	{
+		FBox Bounds(ForceInit);
+		for (uint32 i = 0; i < VertexBuffer.NumVertices; ++i)
+		{
+			Bounds += VertexBuffers.PositionVertexBuffer.VertexPosition(i);
+		}
+		const FVector Extent = Bounds.Max - Bounds.Min;
+		VertexBuffer.PositionOffset = Bounds.Min;
+		VertexBuffer.PositionScale = FVector(
+			Extent.X > 0.f ? Extent.X / 65535.f : 1.f,
+			Extent.Y > 0.f ? Extent.Y / 65535.f : 1.f,
+			Extent.Z > 0.f ? Extent.Z / 65535.f : 1.f);
+	}
+	Context.PositionOffset = VertexBuffer.PositionOffset;
+	Context.InvPositionScale = FVector(1.f) / VertexBuffer.PositionScale;
+
+	for (const FVertexElement& Element : Layout.Elements)
+	{
+		WriteElement(VertexBuffer.RawData.GetData(), VertexBuffer.Stride, Element, VertexBuffers, Context);
+	}
+}
+
+bool ns_yoyo::FVertexBuffer::GetPositions(TArray<FVector>& OutPositions) const
+{
+	const FVertexElement* Element = Layout.Elements.FindByPredicate([](const FVertexElement& Element)
+	{
+		return Element.Attribute == EVertexAttribute::Position;
+	});
+	if (!Element)
+	{
+		return false;
+	}
+
+	OutPositions.SetNumUninitialized(NumVertices);
+	const uint8* Src = RawData.GetData() + Element->Offset;
+	for (uint32 i = 0; i < NumVertices; ++i, Src += Stride)
 	{
-		// position
-		auto Position = VertexBuffers.PositionVertexBuffer.VertexPosition(i);
-		FloatRawData.Append({ Position.X, Position.Y, Position.Z });
-		// normal
-		auto Normal = VertexBuffers.StaticMeshVertexBuffer.VertexTangentZ(i);
-		FloatRawData.Append({ Normal.X, Normal.Y, Normal.Z });
-		// uv
-		auto UV = VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 0);
-		FloatRawData.Append({ UV.X, UV.Y });
+		if (Element->Encoding == EVertexEncoding::Quantized16)
+		{
+			uint16 Quantized[3];
+			FMemory::Memcpy(Quantized, Src, sizeof(Quantized));
+			OutPositions[i] = PositionOffset + FVector(Quantized[0], Quantized[1], Quantized[2]) * PositionScale;
+		}
+		else
+		{
+			FMemory::Memcpy(&OutPositions[i], Src, sizeof(FVector));
+		}
 	}
+	return true;
 }
 
-void ns_yoyo::ExportStaticIndexBuffer(FIndexBuffer& yyIndexBuffer, FRawStaticIndexBuffer& ueIndexBuffer)
+bool ns_yoyo::FVertexBuffer::GetNormals(TArray<FVector>& OutNormals) const
+{
+	const FVertexElement* Element = Layout.Elements.FindByPredicate([](const FVertexElement& Element)
+	{
+		return Element.Attribute == EVertexAttribute::Normal;
+	});
+	if (!Element)
+	{
+		return false;
+	}
+
+	OutNormals.SetNumUninitialized(NumVertices);
+	const uint8* Src = RawData.GetData() + Element->Offset;
+	for (uint32 i = 0; i < NumVertices; ++i, Src += Stride)
+	{
+		if (Element->Encoding == EVertexEncoding::Oct16)
+		{
+			int16 SNorm[2];
+			FMemory::Memcpy(SNorm, Src, sizeof(SNorm));
+			OutNormals[i] = OctDecode(FVector2D(SNorm[0] / 32767.f, SNorm[1] / 32767.f));
+		}
+		else
+		{
+			FMemory::Memcpy(&OutNormals[i], Src, sizeof(FVector));
+		}
+	}
+	return true;
+}
+
+void ns_yoyo::ExportStaticIndexBuffer(FIndexBuffer& yyIndexBuffer, FRawStaticIndexBuffer& ueIndexBuffer, uint32 NumVertices)
 {
 	yyIndexBuffer.NumIndices = ueIndexBuffer.GetNumIndices();
 	ueIndexBuffer.GetCopy(yyIndexBuffer.BufferData);
+	yyIndexBuffer.SetIndexWidthForVertices(NumVertices);
 }
 
-void ns_yoyo::ExportMultiSizeIndexContainer(FIndexBuffer& yyIndexBuffer, FMultiSizeIndexContainer& ueIndexContainer)
+void ns_yoyo::ExportMultiSizeIndexContainer(FIndexBuffer& yyIndexBuffer, FMultiSizeIndexContainer& ueIndexContainer, uint32 NumVertices)
 {
 	ueIndexContainer.GetIndexBuffer(yyIndexBuffer.BufferData);
 	yyIndexBuffer.NumIndices = yyIndexBuffer.BufferData.Num();
+	yyIndexBuffer.SetIndexWidthForVertices(NumVertices);
+}
+
+void ns_yoyo::ExportSkinWeightBuffer(FSkinWeightBuffer& yySkinWeightBuffer, const FSkinWeightVertexBuffer& ueSkinWeightBuffer,
+	uint32 MaxBoneInfluences, uint32 MaxSectionBones, bool bPackBoneIndices)
+{
+	const uint32 NumSrcInfluences = ueSkinWeightBuffer.GetMaxBoneInfluences();
+	if (MaxBoneInfluences > 8)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Skin weights with %u influences are cut to the heaviest 8"), MaxBoneInfluences);
+	}
+	yySkinWeightBuffer.NumInfluences = MaxBoneInfluences <= 4 ? 4 : 8;
+	yySkinWeightBuffer.BoneIndexSize = bPackBoneIndices && MaxSectionBones <= 256 ? sizeof(uint8) : sizeof(uint16);
+	yySkinWeightBuffer.NumVertices = ueSkinWeightBuffer.GetNumVertices();
+	const uint32 NumInfluences = yySkinWeightBuffer.NumInfluences;
+	const uint32 BoneIndexSize = yySkinWeightBuffer.BoneIndexSize;
+	const uint32 Stride = yySkinWeightBuffer.GetStride();
+	yySkinWeightBuffer.RawData.SetNumZeroed(yySkinWeightBuffer.NumVertices * Stride);
+	if (yySkinWeightBuffer.NumVertices == 0)
+	{
+		return;
+	}
+
+	// UE keeps the same per vertex layout for constant influence counts
+	const FSkinWeightDataVertexBuffer* ueDataBuffer = ueSkinWeightBuffer.GetDataVertexBuffer();
+	const bool bVariableInfluences = ueSkinWeightBuffer.GetVariableBonesPerVertex();
+	const uint32 SrcBoneIndexSize = ueDataBuffer->GetBoneIndexByteSize();
+	if (!bVariableInfluences && NumSrcInfluences == NumInfluences && SrcBoneIndexSize == BoneIndexSize)
+	{
+		FMemory::Memcpy(yySkinWeightBuffer.RawData.GetData(), ueDataBuffer->GetWeightData(), yySkinWeightBuffer.RawData.Num());
+		// packed indices come with renormalized weights, not those falling back to 16 bits
+		if (BoneIndexSize == sizeof(uint8))
+		{
+			uint8* Weights = yySkinWeightBuffer.RawData.GetData() + NumInfluences * BoneIndexSize;
+			for (uint32 i = 0; i < yySkinWeightBuffer.NumVertices; ++i, Weights += Stride)
+			{
+				RenormalizeWeights(Weights, NumInfluences);
+			}
+		}
+		return;
+	}
+
+	const uint32 SrcStride = NumSrcInfluences * (SrcBoneIndexSize + 1);
+	const uint8* Src = ueDataBuffer->GetWeightData();
+	uint8* Dest = yySkinWeightBuffer.RawData.GetData();
+	uint32 Bones[MAX_TOTAL_INFLUENCES];
+	uint8 Weights[MAX_TOTAL_INFLUENCES];
+	check(NumSrcInfluences <= MAX_TOTAL_INFLUENCES);
+	for (uint32 Vertex = 0; Vertex < yySkinWeightBuffer.NumVertices; ++Vertex, Src += SrcStride, Dest += Stride)
+	{
+		for (uint32 i = 0; i < NumSrcInfluences; ++i)
+		{
+			if (bVariableInfluences)
+			{
+				Bones[i] = ueSkinWeightBuffer.GetBoneIndex(Vertex, i);
+				Weights[i] = ueSkinWeightBuffer.GetBoneWeight(Vertex, i);
+			}
+			else
+			{
+				Bones[i] = SrcBoneIndexSize == sizeof(uint16) ? reinterpret_cast<const uint16*>(Src)[i] : Src[i];
+				Weights[i] = Src[NumSrcInfluences * SrcBoneIndexSize + i];
+			}
+		}
+
+		// more influences than fit, keep the heaviest
+		const bool bTruncate = NumSrcInfluences > NumInfluences;
+		if (bTruncate)
+		{
+			for (uint32 i = 1; i < NumSrcInfluences; ++i)
+			{
+				for (uint32 j = i; j > 0 && Weights[j] > Weights[j - 1]; --j)
+				{
+					Swap(Weights[j], Weights[j - 1]);
+					Swap(Bones[j], Bones[j - 1]);
+				}
+			}
+		}
+
+		const uint32 NumCopied = FMath::Min(NumSrcInfluences, NumInfluences);
+		uint8* DestWeights = Dest + NumInfluences * BoneIndexSize;
+		for (uint32 i = 0; i < NumCopied; ++i)
+		{
+			if (BoneIndexSize == sizeof(uint16))
+			{
+				const uint16 Bone = (uint16)Bones[i];
+				FMemory::Memcpy(Dest + i * sizeof(uint16), &Bone, sizeof(uint16));
+			}
+			else
+			{
+				check(Bones[i] <= MAX_uint8);
+				Dest[i] = (uint8)Bones[i];
+			}
+			DestWeights[i] = Weights[i];
+		}
+		if (bTruncate || BoneIndexSize == sizeof(uint8))
+		{
+			RenormalizeWeights(DestWeights, NumInfluences);
+		}
+	}
 }
 
-ns_yoyo::KTransform ns_yoyo::GetTransform(UPrimitiveComponent* Component)
+ns_yoyo::KTransform ns_yoyo::GetTransform(UPrimitiveComponent* Component, const FTransform& ParentTransform)
 {
 	ns_yoyo::KTransform Trans;
-	auto ueTrans = Component->GetComponentTransform();
+	auto ueTrans = Component->GetComponentTransform() * ParentTransform;
 	Trans.Trans = ueTrans.GetLocation();
 	Trans.Rot = ueTrans.GetRotation();
 	Trans.Scale = ueTrans.GetScale3D();
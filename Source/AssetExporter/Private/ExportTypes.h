@@ -5,6 +5,7 @@
 struct FStaticMeshVertexBuffers;
 class FRawStaticIndexBuffer;
 class FMultiSizeIndexContainer;
+class FSkinWeightVertexBuffer;
 
 namespace ns_yoyo
 {
@@ -15,9 +16,15 @@ namespace ns_yoyo
 		SkeletalMesh,
 		AnimSequence,
 		Skeleton,
+		// a skeletal mesh LOD skinned offline by an animation
+		VertexAnimation,
+		Texture,
 		Max
 	};
 
+	// version of the exported file formats, bump it whenever an operator<< below changes
+	constexpr uint32 ExportFormatVersion = 15;
+
 	struct KTransform
 	{
 		FQuat Rot; // (x,y,z,w), align(16)
@@ -31,6 +38,54 @@ namespace ns_yoyo
 		}
 	};
 
+	// rows of an affine matrix in the column vector convention, world = M * (local, 1)
+	struct FMatrix3x4
+	{
+		float M[3][4];
+
+		// UE matrices transform row vectors, their columns are our rows
+		static FMatrix3x4 FromMatrix(const FMatrix& Matrix)
+		{
+			FMatrix3x4 Result;
+			for (int32 Row = 0; Row < 3; ++Row)
+			{
+				for (int32 Column = 0; Column < 4; ++Column)
+				{
+					Result.M[Row][Column] = Matrix.M[Column][Row];
+				}
+			}
+			return Result;
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FMatrix3x4& Matrix)
+		{
+			for (int32 Row = 0; Row < 3; ++Row)
+			{
+				for (int32 Column = 0; Column < 4; ++Column)
+				{
+					Ar << Matrix.M[Row][Column];
+				}
+			}
+			return Ar;
+		}
+	};
+	static_assert(sizeof(FMatrix3x4) == 48, "FMatrix3x4 must stay 48 bytes");
+
+	// Num, zero padding up to the next 16 byte offset of the archive, then the elements as they are in memory
+	template<typename T>
+	void SerializeAlignedArray(FArchive& Ar, TArray<T>& Array)
+	{
+		int32 Num = Array.Num();
+		Ar << Num;
+		uint8 Padding[16] = {};
+		Ar.Serialize(Padding, Align(Ar.Tell(), 16) - Ar.Tell());
+		if (Ar.IsLoading())
+		{
+			Array.SetNumUninitialized(Num);
+		}
+		Ar.Serialize(Array.GetData(), (int64)Num * sizeof(T));
+	}
+
 	struct FSkeleton
 	{
 		ns_yoyo::EResourceType Type = EResourceType::Skeleton;
@@ -76,31 +131,189 @@ namespace ns_yoyo
 					<< Tracks.ScaleKeys;
 			}
 		};
+
+		/*
+		* A reduced and quantized channel, see AnimCompression.h.
+		* Keys are interpolated linearly (positions, scales) or with FQuat::Slerp (rotations)
+		* between the frames in KeyFrames, a single key is constant over the whole sequence.
+		*/
+		struct FCompressedChannel
+		{
+			// frame of every key, empty when every frame has a key
+			TArray<uint16> KeyFrames;
+			// vectors only, Value = RangeMin + Data / 65535 * RangeExtent
+			FVector RangeMin = FVector::ZeroVector;
+			FVector RangeExtent = FVector::ZeroVector;
+			// 3 per key, 16 bit range quantized vectors or 48 bit smallest three rotations
+			TArray<uint16> Data;
+			friend FArchive& operator<<(FArchive& Ar, FCompressedChannel& Channel)
+			{
+				return Ar << Channel.KeyFrames
+					<< Channel.RangeMin
+					<< Channel.RangeExtent
+					<< Channel.Data;
+			}
+		};
+		struct FCompressedTrack
+		{
+			FCompressedChannel PosKeys;
+			FCompressedChannel RotKeys;
+			FCompressedChannel ScaleKeys;
+			friend FArchive& operator<<(FArchive& Ar, FCompressedTrack& Track)
+			{
+				return Ar << Track.PosKeys
+					<< Track.RotKeys
+					<< Track.ScaleKeys;
+			}
+		};
+
+		// what BakedMatrices hold
+		enum class EBakedSpace : uint8
+		{
+			None,
+			// bone to model space
+			Model,
+			// model space of the skeleton's bind pose to the animated model space, what skinning uploads
+			Skinning,
+			Max
+		};
+
 		int32 NumFrames;
+		// frames per second, the keys are 1 / FrameRate seconds apart
+		float FrameRate = 30.f;
+		// exactly one of the two is filled
 		TArray<FTrack> RawAnimationData;
+		TArray<FCompressedTrack> CompressedAnimationData;
+		// bone of the skeleton every track animates
+		TArray<int32> TrackToBoneIndices;
 		FString SkelAssetPath;
+		EBakedSpace BakedSpace = EBakedSpace::None;
+		// every bone of the skeleton, NumFrames * NumBakedBones matrices, all bones of frame 0 first
+		int32 NumBakedBones = 0;
+		TArray<FMatrix3x4> BakedMatrices;
 		friend FArchive& operator<<(FArchive& Ar, FAnimSequenceResource& AnimSeq)
 		{
-			return Ar << AnimSeq.Type
+			Ar << AnimSeq.Type
 				<< AnimSeq.Path
 				<< AnimSeq.NumFrames
+				<< AnimSeq.FrameRate
 				<< AnimSeq.RawAnimationData
-				<< AnimSeq.SkelAssetPath;
+				<< AnimSeq.CompressedAnimationData
+				<< AnimSeq.TrackToBoneIndices
+				<< AnimSeq.SkelAssetPath
+				<< AnimSeq.BakedSpace
+				<< AnimSeq.NumBakedBones;
+			SerializeAlignedArray(Ar, AnimSeq.BakedMatrices);
+			return Ar;
+		}
+	};
+
+	enum class EVertexAttribute : uint8
+	{
+		Position,
+		Normal,
+		// TangentX, w or the encoding carries the binormal sign
+		Tangent,
+		Color,
+		// Index picks the channel
+		TexCoord,
+		Max
+	};
+
+	enum class EVertexEncoding : uint8
+	{
+		Float2,
+		Float3,
+		Float4,
+		// 2 x half
+		Half2,
+		// unit vector, octahedral in 2 x int16 snorm, for tangents the lowest bit of y holds the binormal sign
+		Oct16,
+		// 4 x uint16 unorm (w unused), decoded as PositionOffset + Q * PositionScale
+		Quantized16,
+		// 4 x uint8 unorm, rgba
+		RGBA8,
+		Max
+	};
+
+	struct FVertexElement
+	{
+		EVertexAttribute Attribute = EVertexAttribute::Position;
+		// texcoord channel, 0 otherwise
+		uint8 Index = 0;
+		EVertexEncoding Encoding = EVertexEncoding::Float3;
+		// byte offset inside a vertex
+		uint8 Offset = 0;
+
+		bool operator==(const FVertexElement& Other) const
+		{
+			return Attribute == Other.Attribute
+				&& Index == Other.Index
+				&& Encoding == Other.Encoding
+				&& Offset == Other.Offset;
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FVertexElement& Element)
+		{
+			return Ar << Element.Attribute
+				<< Element.Index
+				<< Element.Encoding
+				<< Element.Offset;
+		}
+	};
+
+	struct FVertexLayout
+	{
+		TArray<FVertexElement> Elements;
+
+		uint32 GetStride() const;
+
+		bool operator==(const FVertexLayout& Other) const { return Elements == Other.Elements; }
+
+		// position float3, normal float3, uv0 float2, 32 bytes
+		static FVertexLayout Default();
+
+		/*
+		* parses "Attribute=Encoding" pairs separated by spaces, e.g.
+		* "Position=Quantized16 Normal=Oct16 Tangent=Oct16 TexCoord0=Half2 TexCoord1=Half2 Color=RGBA8"
+		* elements are laid out in the given order
+		*/
+		static bool Parse(const FString& Desc, FVertexLayout& OutLayout);
+
+		friend FArchive& operator<<(FArchive& Ar, FVertexLayout& Layout)
+		{
+			return Ar << Layout.Elements;
 		}
 	};
 
 	class FVertexBuffer
 	{
 	public:
+		FVertexLayout Layout;
 		uint32 Stride;
 		uint32 NumVertices;
-		TArray<float> RawData;
+		// only meaningful for EVertexEncoding::Quantized16 positions
+		FVector PositionOffset = FVector::ZeroVector;
+		FVector PositionScale = FVector::OneVector;
+		// NumVertices * Stride bytes, interleaved as described by Layout
+		TArray<uint8> RawData;
+		// shared blob holding RawData under the output root, RawData is empty when set
+		FString BlobPath;
+
+		// decodes the position of every vertex, false when the layout has no position
+		bool GetPositions(TArray<FVector>& OutPositions) const;
+		// decodes the normal of every vertex, false when the layout has no normal
+		bool GetNormals(TArray<FVector>& OutNormals) const;
 
 		friend FArchive& operator<<(FArchive& Ar, FVertexBuffer& Buffer)
 		{
-			return Ar << Buffer.Stride
+			return Ar << Buffer.Layout
+				<< Buffer.Stride
 				<< Buffer.NumVertices
-				<< Buffer.RawData;
+				<< Buffer.PositionOffset
+				<< Buffer.PositionScale
+				<< Buffer.RawData
+				<< Buffer.BlobPath;
 		}
 	};
 
@@ -108,12 +321,48 @@ namespace ns_yoyo
 	{
 	public:
 		uint32 NumIndices;
+		// bytes per index in the file, 2 when the mesh has at most 65535 vertices, otherwise 4
+		uint32 IndexWidth = sizeof(uint32);
+		// always 32 bit in memory, narrowed when serialized
 		TArray<uint32> BufferData;
+		// shared blob holding the indices in IndexWidth bytes, BufferData is empty when set
+		FString BlobPath;
+
+		void SetIndexWidthForVertices(uint32 NumVertices)
+		{
+			IndexWidth = NumVertices <= MAX_uint16 ? sizeof(uint16) : sizeof(uint32);
+		}
 
 		friend FArchive& operator<<(FArchive& Ar, FIndexBuffer& Buffer)
 		{
-			return Ar << Buffer.NumIndices
-				<< Buffer.BufferData;
+			Ar << Buffer.NumIndices
+				<< Buffer.IndexWidth;
+			if (Buffer.IndexWidth == sizeof(uint16))
+			{
+				TArray<uint16> ShortData;
+				if (Ar.IsSaving())
+				{
+					ShortData.SetNumUninitialized(Buffer.BufferData.Num());
+					for (int32 i = 0; i < Buffer.BufferData.Num(); ++i)
+					{
+						ShortData[i] = (uint16)Buffer.BufferData[i];
+					}
+				}
+				Ar << ShortData;
+				if (Ar.IsLoading())
+				{
+					Buffer.BufferData.SetNumUninitialized(ShortData.Num());
+					for (int32 i = 0; i < ShortData.Num(); ++i)
+					{
+						Buffer.BufferData[i] = ShortData[i];
+					}
+				}
+			}
+			else
+			{
+				Ar << Buffer.BufferData;
+			}
+			return Ar << Buffer.BlobPath;
 		}
 	};
 
@@ -146,51 +395,193 @@ namespace ns_yoyo
 		}
 	};
 
+	/*
+	* A cluster of at most FMeshletSettings::MaxVertices vertices and MaxTriangles triangles of one section,
+	* culled as a whole. A renderer rejects it when the bounding sphere is outside the frustum or when
+	* dot(normalize(ConeApex - CameraPosition), ConeAxis) >= ConeCutoff, every triangle faces away then.
+	*/
+	struct FMeshlet
+	{
+		// range in FMeshletBuffer::Vertices
+		uint32 FirstVertex = 0;
+		uint32 NumVertices = 0;
+		// range in FMeshletBuffer::Triangles, in triangles
+		uint32 FirstTriangle = 0;
+		uint32 NumTriangles = 0;
+		// section of the LOD the triangles come from
+		uint32 SectionIndex = 0;
+		FVector BoundsCenter = FVector::ZeroVector;
+		float BoundsRadius = 0.f;
+		FVector ConeApex = FVector::ZeroVector;
+		// zero with a cutoff of 1 when the triangles face too many ways to ever cull
+		FVector ConeAxis = FVector::ZeroVector;
+		float ConeCutoff = 1.f;
+
+		friend FArchive& operator<<(FArchive& Ar, FMeshlet& Meshlet)
+		{
+			return Ar << Meshlet.FirstVertex
+				<< Meshlet.NumVertices
+				<< Meshlet.FirstTriangle
+				<< Meshlet.NumTriangles
+				<< Meshlet.SectionIndex
+				<< Meshlet.BoundsCenter
+				<< Meshlet.BoundsRadius
+				<< Meshlet.ConeApex
+				<< Meshlet.ConeAxis
+				<< Meshlet.ConeCutoff;
+		}
+	};
+	static_assert(sizeof(FMeshlet) == 64, "FMeshlet must stay 64 bytes");
+
+	// the meshlets of one LOD, empty unless meshlets were built
+	struct FMeshletBuffer
+	{
+		// sorted by section
+		TArray<FMeshlet> Meshlets;
+		// indices into the LOD's vertex buffer, referenced by the meshlets
+		TArray<uint32> Vertices;
+		// 3 per triangle, indices into the meshlet's vertices
+		TArray<uint8> Triangles;
+
+		friend FArchive& operator<<(FArchive& Ar, FMeshletBuffer& Buffer)
+		{
+			return Ar << Buffer.Meshlets
+				<< Buffer.Vertices
+				<< Buffer.Triangles;
+		}
+	};
+
+	struct FStaticMeshLOD
+	{
+		// LODs whose vertices are identical in UE share a vertex buffer
+		int32 VertexBufferIndex = 0;
+		// range of the LOD in the mesh's index buffer, its sections' FirstIndex fall inside it
+		uint32 FirstIndex = 0;
+		uint32 NumIndices = 0;
+		// screen size at which the LOD starts to be used, as set on the UE asset
+		float ScreenSize = 0.f;
+		// sub mesh info
+		TArray<FStaticMeshSection> Sections;
+		FMeshletBuffer Meshlets;
+
+		friend FArchive& operator<<(FArchive& Ar, FStaticMeshLOD& LOD)
+		{
+			return Ar << LOD.VertexBufferIndex
+				<< LOD.FirstIndex
+				<< LOD.NumIndices
+				<< LOD.ScreenSize
+				<< LOD.Sections
+				<< LOD.Meshlets;
+		}
+	};
+
+	/*
+	* A material slot of a mesh, sections pick theirs with MaterialIndex. Parameters are the values
+	* the material resolves to, inherited or overridden.
+	*/
+	struct FMaterialInfo
+	{
+		struct FTextureParameter
+		{
+			// empty for textures the material samples without a parameter
+			FString Name;
+			// exported FTextureResource
+			FString TexturePath;
+			friend FArchive& operator<<(FArchive& Ar, FTextureParameter& Parameter)
+			{
+				return Ar << Parameter.Name
+					<< Parameter.TexturePath;
+			}
+		};
+		struct FScalarParameter
+		{
+			FString Name;
+			float Value = 0.f;
+			friend FArchive& operator<<(FArchive& Ar, FScalarParameter& Parameter)
+			{
+				return Ar << Parameter.Name
+					<< Parameter.Value;
+			}
+		};
+		struct FVectorParameter
+		{
+			FString Name;
+			FLinearColor Value = FLinearColor::Black;
+			friend FArchive& operator<<(FArchive& Ar, FVectorParameter& Parameter)
+			{
+				return Ar << Parameter.Name
+					<< Parameter.Value;
+			}
+		};
+
+		FString SlotName;
+		// path name of the UE material, empty for an empty slot
+		FString MaterialPath;
+		TArray<FTextureParameter> Textures;
+		TArray<FScalarParameter> ScalarParameters;
+		TArray<FVectorParameter> VectorParameters;
+
+		friend FArchive& operator<<(FArchive& Ar, FMaterialInfo& Material)
+		{
+			return Ar << Material.SlotName
+				<< Material.MaterialPath
+				<< Material.Textures
+				<< Material.ScalarParameters
+				<< Material.VectorParameters;
+		}
+	};
+
 	struct FStaticMeshResource
 	{
 		ns_yoyo::EResourceType Type = EResourceType::StaticMesh;
 		// asset path as id
 		FString Path;
-		// sub mesh info
-		TArray<FStaticMeshSection> Sections;
+		// exported LODs, most detailed first
+		TArray<FStaticMeshLOD> LODs;
 		// raw vertex data
-		FVertexBuffer VertexBuffer;
-		// index data
+		TArray<FVertexBuffer> VertexBuffers;
+		// index data of every LOD back to back, relative to the LOD's vertex buffer
 		FIndexBuffer IndexBuffer;
+		// indexed by FStaticMeshSection::MaterialIndex
+		TArray<FMaterialInfo> Materials;
 
 		inline friend FArchive& operator<<(FArchive& Ar, FStaticMeshResource& Resource)
 		{
 			// Type must go first
 			return Ar << Resource.Type
 				<< Resource.Path
-				<< Resource.Sections
-				<< Resource.VertexBuffer
-				<< Resource.IndexBuffer;
+				<< Resource.LODs
+				<< Resource.VertexBuffers
+				<< Resource.IndexBuffer
+				<< Resource.Materials;
 		}
 	};
 
-	struct FSkinWeightInfo
-	{
-		uint16 InfluenceBones[4];
-		uint8 InfluenceWeights[4];
-		friend FArchive& operator<<(FArchive& Ar, FSkinWeightInfo& Info)
-		{
-			Ar.Serialize(Info.InfluenceBones, sizeof(Info.InfluenceBones));
-			Ar.Serialize(Info.InfluenceWeights, sizeof(Info.InfluenceWeights));
-			return Ar;
-		}
-	};
+	/*
+	* Per vertex NumInfluences bone indices of BoneIndexSize bytes, then NumInfluences uint8 weights.
+	* Bone indices index the BoneMap of the vertex's section, unused influences have weight 0.
+	*/
 	struct FSkinWeightBuffer
 	{
-		TArray<FSkinWeightInfo> SkinWeightInfos;
+		// 4, or 8 for meshes with more than 4 influences
+		uint32 NumInfluences = 4;
+		// 2, or 1 when packed and no section has more than 256 bones
+		uint32 BoneIndexSize = sizeof(uint16);
+		uint32 NumVertices = 0;
+		// NumVertices * GetStride() bytes
+		TArray<uint8> RawData;
+		// shared blob holding RawData, RawData is empty when set
+		FString BlobPath;
+
+		uint32 GetStride() const { return NumInfluences * (BoneIndexSize + 1); }
+
 		friend FArchive& operator<<(FArchive& Ar, FSkinWeightBuffer& Buffer)
 		{
-			uint32 TypeSize = Buffer.SkinWeightInfos.GetTypeSize();
-			uint32 ArrayNum = Buffer.SkinWeightInfos.Num();
-			Ar << TypeSize;
-			Ar << ArrayNum;
-			Ar.Serialize(Buffer.SkinWeightInfos.GetData(), TypeSize * ArrayNum);
-			return Ar;
+			return Ar << Buffer.NumInfluences
+				<< Buffer.BoneIndexSize
+				<< Buffer.NumVertices
+				<< Buffer.RawData
+				<< Buffer.BlobPath;
 		}
 	};
 
@@ -198,7 +589,7 @@ namespace ns_yoyo
 	{
 		/** Material (texture) used for this section. */
 		int32 MaterialIndex;
-		/** The offset of this section's indices in the LOD's index buffer. */
+		/** The offset of this section's indices in the mesh's index buffer. */
 		uint32 BaseIndex;
 		/** The number of triangles in this section. */
 		uint32 NumTriangles;
@@ -235,46 +626,355 @@ namespace ns_yoyo
 				<< Section.BoneMap;
 		}
 	};
+
+	struct FSkeletalMeshLOD
+	{
+		// LODs whose vertices and skin weights are identical in UE share a vertex buffer
+		int32 VertexBufferIndex = 0;
+		// range of the LOD in the mesh's index buffer, its sections' BaseIndex fall inside it
+		uint32 FirstIndex = 0;
+		uint32 NumIndices = 0;
+		// screen size at which the LOD starts to be used, as set on the UE asset
+		float ScreenSize = 0.f;
+		// sub mesh info
+		TArray<FSkelMeshRenderSection> RenderSections;
+		FMeshletBuffer Meshlets;
+
+		friend FArchive& operator<<(FArchive& Ar, FSkeletalMeshLOD& LOD)
+		{
+			return Ar << LOD.VertexBufferIndex
+				<< LOD.FirstIndex
+				<< LOD.NumIndices
+				<< LOD.ScreenSize
+				<< LOD.RenderSections
+				<< LOD.Meshlets;
+		}
+	};
+
 	struct FSkeletalMeshResource
 	{
 		ns_yoyo::EResourceType Type = EResourceType::SkeletalMesh;
 		// asset path as id
 		FString Path;
-		// sub mesh info
-		TArray<FSkelMeshRenderSection> RenderSections;
+		// exported LODs, most detailed first
+		TArray<FSkeletalMeshLOD> LODs;
 		// raw vertex data
-		FVertexBuffer VertexBuffer;
-		// index data
+		TArray<FVertexBuffer> VertexBuffers;
+		// index data of every LOD back to back, relative to the LOD's vertex buffer
 		FIndexBuffer IndexBuffer;
-		// skin weight data
-		FSkinWeightBuffer SkinWeightBuffer;
+		// skin weight data, one per vertex buffer
+		TArray<FSkinWeightBuffer> SkinWeightBuffers;
 		// referenced skeleton
 		FString SkelAssetPath;
+		// indexed by FSkelMeshRenderSection::MaterialIndex
+		TArray<FMaterialInfo> Materials;
 
 		inline friend FArchive& operator<<(FArchive& Ar, FSkeletalMeshResource& Resource)
 		{
 			// Type must go first
 			return Ar << Resource.Type
 				<< Resource.Path
-				<< Resource.RenderSections
-				<< Resource.VertexBuffer
+				<< Resource.LODs
+				<< Resource.VertexBuffers
 				<< Resource.IndexBuffer
-				<< Resource.SkinWeightBuffer
-				<< Resource.SkelAssetPath;
+				<< Resource.SkinWeightBuffers
+				<< Resource.SkelAssetPath
+				<< Resource.Materials;
 		}
 	};
 
-	struct FStaticMeshSceneInfo
+	// axis aligned box without FBox's validity flag, 24 bytes in files
+	struct FAABB
 	{
-		// path relative to the Content folder
-		FString ResourcePath;
-		// world transformation
-		KTransform Transform;
-		inline friend FArchive& operator<<(FArchive& Ar,
-			FStaticMeshSceneInfo& StaticMeshSceneInfo)
+		FVector Min;
+		FVector Max;
+
+		FAABB() : Min(MAX_flt), Max(-MAX_flt) {}
+		FAABB(const FVector& InMin, const FVector& InMax) : Min(InMin), Max(InMax) {}
+		explicit FAABB(const FBox& Box) : Min(Box.Min), Max(Box.Max) {}
+
+		bool IsValid() const { return Min.X <= Max.X && Min.Y <= Max.Y && Min.Z <= Max.Z; }
+		FVector GetCenter() const { return (Min + Max) * 0.5f; }
+		float GetSurfaceArea() const
+		{
+			const FVector Extent = Max - Min;
+			return 2.f * (Extent.X * Extent.Y + Extent.Y * Extent.Z + Extent.Z * Extent.X);
+		}
+		FAABB& operator+=(const FAABB& Other)
+		{
+			Min = Min.ComponentMin(Other.Min);
+			Max = Max.ComponentMax(Other.Max);
+			return *this;
+		}
+		FAABB& operator+=(const FVector& Point)
+		{
+			Min = Min.ComponentMin(Point);
+			Max = Max.ComponentMax(Point);
+			return *this;
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FAABB& Box)
+		{
+			return Ar << Box.Min
+				<< Box.Max;
+		}
+	};
+	static_assert(sizeof(FAABB) == 24, "FAABB must stay 24 bytes");
+
+	/*
+	* One LOD of a skeletal mesh skinned offline at every frame of an animation, for crowds drawn
+	* without skinning. The deltas are textures of NumVertices x NumFrames texels, a row per frame,
+	* each texel 4 halves (x, y, z, 0) added to the position or normal of the vertex in the LOD's
+	* vertex buffer of the exported mesh.
+	*/
+	struct FVertexAnimationResource
+	{
+		ns_yoyo::EResourceType Type = EResourceType::VertexAnimation;
+		FString Path;
+		FString SkelMeshPath;
+		FString AnimSeqPath;
+		// index into FSkeletalMeshResource::LODs of the mesh
+		int32 LODIndex = 0;
+		uint32 NumVertices = 0;
+		int32 NumFrames = 0;
+		float FrameRate = 30.f;
+		// skinned positions over the whole animation and at every frame
+		FAABB Bounds;
+		TArray<FAABB> FrameBounds;
+		// NumFrames * NumVertices * 4 FFloat16 bits each, the normals are renormalized after skinning
+		TArray<uint16> PositionDeltas;
+		TArray<uint16> NormalDeltas;
+
+		friend FArchive& operator<<(FArchive& Ar, FVertexAnimationResource& Resource)
+		{
+			Ar << Resource.Type
+				<< Resource.Path
+				<< Resource.SkelMeshPath
+				<< Resource.AnimSeqPath
+				<< Resource.LODIndex
+				<< Resource.NumVertices
+				<< Resource.NumFrames
+				<< Resource.FrameRate
+				<< Resource.Bounds
+				<< Resource.FrameBounds;
+			SerializeAlignedArray(Ar, Resource.PositionDeltas);
+			SerializeAlignedArray(Ar, Resource.NormalDeltas);
+			return Ar;
+		}
+	};
+
+	enum class ETextureFormat : uint8
+	{
+		// 4 x uint8 unorm, rgba
+		RGBA8,
+		// uint8 unorm
+		R8,
+		// block compressed, 4x4 texels in 8 (BC1, BC4) or 16 bytes
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		BC6H,
+		BC7,
+		// 4 x half
+		RGBA16F,
+		Max
+	};
+
+	struct FTextureMip
+	{
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		// rows of texels or of 4x4 blocks, tightly packed
+		TArray<uint8> Data;
+		// shared blob holding Data, Data is empty when set
+		FString BlobPath;
+
+		friend FArchive& operator<<(FArchive& Ar, FTextureMip& Mip)
+		{
+			Ar << Mip.SizeX
+				<< Mip.SizeY;
+			SerializeAlignedArray(Ar, Mip.Data);
+			return Ar << Mip.BlobPath;
+		}
+	};
+
+	// a UTexture2D transcoded from its platform data into what a GPU upload takes
+	struct FTextureResource
+	{
+		ns_yoyo::EResourceType Type = EResourceType::Texture;
+		FString Path;
+		ETextureFormat Format = ETextureFormat::RGBA8;
+		bool bSRGB = false;
+		// most detailed first
+		TArray<FTextureMip> Mips;
+
+		friend FArchive& operator<<(FArchive& Ar, FTextureResource& Resource)
+		{
+			return Ar << Resource.Type
+				<< Resource.Path
+				<< Resource.Format
+				<< Resource.bSRGB
+				<< Resource.Mips;
+		}
+	};
+
+	/*
+	* Every placement of one static mesh, actors and ISM/HISM/foliage instances alike,
+	* so a renderer issues one instanced draw per group. Transforms are split into
+	* one contiguous array per component, indexed by instance.
+	*/
+	struct FStaticMeshInstanceGroup
+	{
+		// index into FLevelSceneInfo::StaticMeshResourcePaths
+		int32 ResourceIndex = INDEX_NONE;
+		// world transformations
+		TArray<FQuat> Rotations;
+		TArray<FVector> Translations;
+		TArray<FVector> Scales;
+		// world space bounds of every instance
+		TArray<FAABB> Bounds;
+
+		int32 GetNumInstances() const { return Translations.Num(); }
+
+		void AddInstance(const FTransform& Transform, const FBox& LocalBounds)
+		{
+			Rotations.Add(Transform.GetRotation());
+			Translations.Add(Transform.GetLocation());
+			Scales.Add(Transform.GetScale3D());
+			Bounds.Add(FAABB(LocalBounds.TransformBy(Transform)));
+		}
+
+		void CopyInstance(const FStaticMeshInstanceGroup& From, int32 InstanceIndex)
+		{
+			Rotations.Add(From.Rotations[InstanceIndex]);
+			Translations.Add(From.Translations[InstanceIndex]);
+			Scales.Add(From.Scales[InstanceIndex]);
+			Bounds.Add(From.Bounds[InstanceIndex]);
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FStaticMeshInstanceGroup& Group)
+		{
+			return Ar << Group.ResourceIndex
+				<< Group.Rotations
+				<< Group.Translations
+				<< Group.Scales
+				<< Group.Bounds;
+		}
+	};
+
+	/*
+	* Node of a flattened BVH, 32 bytes, two per cache line. Nodes are stored depth first:
+	* the left child of an inner node directly follows it, so only the right child is indexed.
+	*/
+	struct FBVHNode
+	{
+		FVector BoundsMin;
+		// leaves: first entry in FSceneBVH::InstanceIndices, inner nodes: index of the right child
+		uint32 RightChildOrFirstInstance;
+		FVector BoundsMax;
+		// 0 for inner nodes
+		uint32 NumInstances;
+
+		bool IsLeaf() const { return NumInstances > 0; }
+
+		friend FArchive& operator<<(FArchive& Ar, FBVHNode& Node)
+		{
+			return Ar << Node.BoundsMin
+				<< Node.RightChildOrFirstInstance
+				<< Node.BoundsMax
+				<< Node.NumInstances;
+		}
+	};
+	static_assert(sizeof(FBVHNode) == 32, "FBVHNode must stay 32 bytes");
+
+	/*
+	* SAH bounding volume hierarchy over the static mesh instances of a scene, see SceneBVH.h.
+	* Instances are numbered across all instance groups back to back, in group order.
+	*/
+	struct FSceneBVH
+	{
+		// Nodes[0] is the root, empty when the scene has no instances
+		TArray<FBVHNode> Nodes;
+		// the leaves' instances, contiguous per leaf
+		TArray<uint32> InstanceIndices;
+
+		friend FArchive& operator<<(FArchive& Ar, FSceneBVH& BVH)
+		{
+			return Ar << BVH.Nodes
+				<< BVH.InstanceIndices;
+		}
+	};
+
+	/*
+	* Index entry of one grid cell of a chunked scene, see SceneCells.h.
+	* The cell's instances live in their own scene file so a runtime can stream it on its own.
+	*/
+	struct FSceneCell
+	{
+		// scene chunk of the cell, relative to the output root
+		FString Path;
+		// the cell covers Coord * CellSize to (Coord + 1) * CellSize on the XY plane
+		FIntPoint Coord;
+		// bounds of the instances in the cell, which may reach past the grid cell
+		FAABB Bounds;
+		uint32 NumInstances = 0;
+		// meshes the chunk needs, indices into FLevelSceneInfo::StaticMeshResourcePaths of the index
+		TArray<int32> ResourceIndices;
+
+		friend FArchive& operator<<(FArchive& Ar, FSceneCell& Cell)
+		{
+			return Ar << Cell.Path
+				<< Cell.Coord
+				<< Cell.Bounds
+				<< Cell.NumInstances
+				<< Cell.ResourceIndices;
+		}
+	};
+
+	// how FLevelSceneInfo stores its instances, AssetExporter.SceneEncoding
+	enum class ESceneEncoding : uint8
+	{
+		// static mesh instance groups and one FSkeletalMeshSceneInfo per skeletal mesh
+		Records,
+		// FSceneInstanceColumns with rotation, translation and scale columns
+		Components,
+		// FSceneInstanceColumns with 3x4 world matrices
+		Matrices,
+		Max
+	};
+
+	/*
+	* Every instance of one kind of a scene in columns, the per-frame transform upload of a runtime
+	* is a straight copy of a column. Instances keep their group order, so those of one resource are
+	* contiguous and the BVH indexes them unchanged. Every column starts 16 bytes aligned from the
+	* start of the file. Resource indices are 4 bytes, rotations, translations and scales 16 with
+	* w = 0 padding the xyz columns, matrices 48 and bounds 24.
+	*/
+	struct FSceneInstanceColumns
+	{
+		// index into the resource path table of the instances' kind
+		TArray<uint32> ResourceIndices;
+		// ESceneEncoding::Components
+		TArray<FQuat> Rotations;
+		TArray<FVector4> Translations;
+		TArray<FVector4> Scales;
+		// ESceneEncoding::Matrices
+		TArray<FMatrix3x4> Matrices;
+		// world space bounds, static meshes only
+		TArray<FAABB> Bounds;
+
+		int32 GetNumInstances() const { return ResourceIndices.Num(); }
+
+		friend FArchive& operator<<(FArchive& Ar, FSceneInstanceColumns& Columns)
 		{
-			return Ar << StaticMeshSceneInfo.ResourcePath
-				<< StaticMeshSceneInfo.Transform;
+			SerializeAlignedArray(Ar, Columns.ResourceIndices);
+			SerializeAlignedArray(Ar, Columns.Rotations);
+			SerializeAlignedArray(Ar, Columns.Translations);
+			SerializeAlignedArray(Ar, Columns.Scales);
+			SerializeAlignedArray(Ar, Columns.Matrices);
+			SerializeAlignedArray(Ar, Columns.Bounds);
+			return Ar;
 		}
 	};
 
@@ -330,15 +1030,41 @@ namespace ns_yoyo
 	{
 		FCameraSceneInfo Camera;
 		FDirectionalLightSceneInfo DirectionalLight;
-		TArray<FStaticMeshSceneInfo> StaticMesheSceneInfos;
+		// paths relative to the Content folder, each mesh once
+		TArray<FString> StaticMeshResourcePaths;
+		ESceneEncoding Encoding = ESceneEncoding::Records;
+		// ESceneEncoding::Records
+		TArray<FStaticMeshInstanceGroup> StaticMeshInstanceGroups;
 		TArray<FSkeletalMeshSceneInfo> SkelMeshSceneInfos;
+		// ESceneEncoding::Components and Matrices, see EncodeSceneColumns
+		FSceneInstanceColumns StaticMeshInstances;
+		TArray<FString> SkelMeshResourcePaths;
+		FSceneInstanceColumns SkelMeshInstances;
+		FSceneBVH StaticMeshBVH;
+		// chunked scenes only: the instances are in the cells' files, the groups and BVH above are empty
+		float CellSize = 0.f;
+		TArray<FSceneCell> Cells;
 
 		friend FArchive& operator<<(FArchive& Ar, FLevelSceneInfo& SceneInfo)
 		{
 			Ar << SceneInfo.Camera;
 			Ar << SceneInfo.DirectionalLight;
-			Ar << SceneInfo.StaticMesheSceneInfos;
-			Ar << SceneInfo.SkelMeshSceneInfos;
+			Ar << SceneInfo.StaticMeshResourcePaths;
+			Ar << SceneInfo.Encoding;
+			if (SceneInfo.Encoding == ESceneEncoding::Records)
+			{
+				Ar << SceneInfo.StaticMeshInstanceGroups;
+				Ar << SceneInfo.SkelMeshSceneInfos;
+			}
+			else
+			{
+				Ar << SceneInfo.StaticMeshInstances;
+				Ar << SceneInfo.SkelMeshResourcePaths;
+				Ar << SceneInfo.SkelMeshInstances;
+			}
+			Ar << SceneInfo.StaticMeshBVH;
+			Ar << SceneInfo.CellSize;
+			Ar << SceneInfo.Cells;
 			return Ar;
 		}
 	};
@@ -357,13 +1083,24 @@ namespace ns_yoyo
 		}
 	};
 
-	void ExportVertexBuffer(FVertexBuffer& yyVertexBuffer, FStaticMeshVertexBuffers& ueVertexBuffers);
+	void ExportVertexBuffer(FVertexBuffer& yyVertexBuffer, FStaticMeshVertexBuffers& ueVertexBuffers,
+		const FVertexLayout& Layout = FVertexLayout::Default());
+
+	void ExportStaticIndexBuffer(FIndexBuffer& yyIndexBuffer, FRawStaticIndexBuffer& ueIndexBuffer, uint32 NumVertices);
 
-	void ExportStaticIndexBuffer(FIndexBuffer& yyIndexBuffer, FRawStaticIndexBuffer& ueIndexBuffer);
+	void ExportMultiSizeIndexContainer(FIndexBuffer& yyIndexBuffer, FMultiSizeIndexContainer& ueIndexContainer, uint32 NumVertices);
 
-	void ExportMultiSizeIndexContainer(FIndexBuffer& yyIndexBuffer, FMultiSizeIndexContainer& ueIndexContainer);
+	/*
+	* Copies skin weights with MaxBoneInfluences (from the sections) rounded up to 4 or 8 influences,
+	* the heaviest are kept and renormalized beyond 8. Bone indices stay 16 bit unless bPackBoneIndices
+	* and no section has more than 256 bones (MaxSectionBones), packed weights are renormalized to sum to 255.
+	* Buffers already in the output layout are copied in one go.
+	*/
+	void ExportSkinWeightBuffer(FSkinWeightBuffer& yySkinWeightBuffer, const FSkinWeightVertexBuffer& ueSkinWeightBuffer,
+		uint32 MaxBoneInfluences, uint32 MaxSectionBones, bool bPackBoneIndices);
 
-	ns_yoyo::KTransform GetTransform(UPrimitiveComponent* Component);
+	// world transform of the component, placed by ParentTransform for levels loaded outside of their world
+	ns_yoyo::KTransform GetTransform(UPrimitiveComponent* Component, const FTransform& ParentTransform = FTransform::Identity);
 
 	inline FVector4 Quat2Vec4(const FQuat& Quat)
 	{
@@ -0,0 +1,364 @@
+#include "MappedResource.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	struct FBlobPiece
+	{
+		const void* Data;
+		uint64 Size;
+	};
+
+	// collects blobs by reference and writes them behind the header and section table
+	class FMappedWriter
+	{
+	public:
+		void AddBlob(ns_yoyo::EMappedSection Id, uint32 ElementSize, const void* Data, uint64 Size)
+		{
+			TArray<FBlobPiece> Pieces;
+			Pieces.Add({ Data, Size });
+			AddBlob(Id, ElementSize, MoveTemp(Pieces));
+		}
+
+		void AddBlob(ns_yoyo::EMappedSection Id, uint32 ElementSize, TArray<FBlobPiece> Pieces)
+		{
+			FBlob& Blob = Blobs.AddDefaulted_GetRef();
+			Blob.Id = Id;
+			Blob.ElementSize = ElementSize;
+			Blob.Size = 0;
+			for (const FBlobPiece& Piece : Pieces)
+			{
+				Blob.Size += Piece.Size;
+			}
+			Blob.Pieces = MoveTemp(Pieces);
+		}
+
+		// the regular stream of the resource, whose large arrays were moved out beforehand
+		template<typename T>
+		void AddMeta(T& Resource)
+		{
+			FMemoryWriter MetaWriter(Meta);
+			MetaWriter << Resource;
+			AddBlob(ns_yoyo::EMappedSection::Meta, 1, Meta.GetData(), Meta.Num());
+		}
+
+		bool Write(FArchive& Ar, ns_yoyo::EResourceType Type)
+		{
+			using namespace ns_yoyo;
+			FMappedHeader Header;
+			FMemory::Memzero(Header);
+			Header.Type = Type;
+			Header.Magic = MappedMagic;
+			Header.FormatVersion = ExportFormatVersion;
+			Header.NumSections = Blobs.Num();
+
+			TArray<FMappedSection> Sections;
+			uint64 Offset = Align(sizeof(FMappedHeader) + Blobs.Num() * sizeof(FMappedSection), MappedAlignment);
+			for (const FBlob& Blob : Blobs)
+			{
+				FMappedSection& Section = Sections.AddZeroed_GetRef();
+				Section.Id = Blob.Id;
+				Section.ElementSize = Blob.ElementSize;
+				Section.Offset = Offset;
+				Section.Size = Blob.Size;
+				Offset = Align(Offset + Blob.Size, MappedAlignment);
+			}
+
+			Ar.Serialize(&Header, sizeof(Header));
+			Ar.Serialize(Sections.GetData(), Sections.Num() * sizeof(FMappedSection));
+			uint64 Written = sizeof(Header) + Sections.Num() * sizeof(FMappedSection);
+			uint8 Padding[MappedAlignment] = {};
+			for (int32 i = 0; i < Blobs.Num(); ++i)
+			{
+				Ar.Serialize(Padding, Sections[i].Offset - Written);
+				for (const FBlobPiece& Piece : Blobs[i].Pieces)
+				{
+					Ar.Serialize(const_cast<void*>(Piece.Data), Piece.Size);
+				}
+				Written = Sections[i].Offset + Sections[i].Size;
+			}
+			return !Ar.IsError();
+		}
+
+	private:
+		struct FBlob
+		{
+			ns_yoyo::EMappedSection Id;
+			uint32 ElementSize;
+			uint64 Size;
+			TArray<FBlobPiece> Pieces;
+		};
+		TArray<FBlob> Blobs;
+		TArray<uint8> Meta;
+	};
+
+	// moves the meshlets of every LOD out, empty when none were built
+	template<typename TLOD>
+	TArray<ns_yoyo::FMeshletBuffer> TakeMeshlets(TArray<TLOD>& LODs)
+	{
+		TArray<ns_yoyo::FMeshletBuffer> Meshlets;
+		if (LODs.ContainsByPredicate([](const TLOD& LOD) { return LOD.Meshlets.Meshlets.Num() > 0; }))
+		{
+			Meshlets.Reserve(LODs.Num());
+			for (TLOD& LOD : LODs)
+			{
+				Meshlets.Add(MoveTemp(LOD.Meshlets));
+			}
+		}
+		return Meshlets;
+	}
+
+	template<typename TLOD>
+	void RestoreMeshlets(TArray<TLOD>& LODs, TArray<ns_yoyo::FMeshletBuffer>& Meshlets)
+	{
+		for (int32 i = 0; i < Meshlets.Num(); ++i)
+		{
+			LODs[i].Meshlets = MoveTemp(Meshlets[i]);
+		}
+	}
+
+	void AddMeshletBlobs(FMappedWriter& Writer, const TArray<ns_yoyo::FMeshletBuffer>& Meshlets)
+	{
+		using namespace ns_yoyo;
+		for (const FMeshletBuffer& Buffer : Meshlets)
+		{
+			Writer.AddBlob(EMappedSection::Meshlets, sizeof(FMeshlet), Buffer.Meshlets.GetData(), Buffer.Meshlets.Num() * sizeof(FMeshlet));
+			Writer.AddBlob(EMappedSection::MeshletVertices, sizeof(uint32), Buffer.Vertices.GetData(), Buffer.Vertices.Num() * sizeof(uint32));
+			Writer.AddBlob(EMappedSection::MeshletTriangles, 3, Buffer.Triangles.GetData(), Buffer.Triangles.Num());
+		}
+	}
+
+	// indices are stored in the width the loader uploads, narrowing into ShortIndices if needed
+	void AddIndexBlob(FMappedWriter& Writer, uint32 IndexWidth, const TArray<uint32>& Indices, TArray<uint16>& ShortIndices)
+	{
+		if (IndexWidth == sizeof(uint16))
+		{
+			ShortIndices.SetNumUninitialized(Indices.Num());
+			for (int32 i = 0; i < Indices.Num(); ++i)
+			{
+				ShortIndices[i] = (uint16)Indices[i];
+			}
+			Writer.AddBlob(ns_yoyo::EMappedSection::IndexData, sizeof(uint16), ShortIndices.GetData(), ShortIndices.Num() * sizeof(uint16));
+		}
+		else
+		{
+			Writer.AddBlob(ns_yoyo::EMappedSection::IndexData, sizeof(uint32), Indices.GetData(), Indices.Num() * sizeof(uint32));
+		}
+	}
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FStaticMeshResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<TArray<uint8>> VertexData;
+	VertexData.Reserve(Resource.VertexBuffers.Num());
+	for (FVertexBuffer& VertexBuffer : Resource.VertexBuffers)
+	{
+		VertexData.Add(MoveTemp(VertexBuffer.RawData));
+	}
+	TArray<uint32> IndexData = MoveTemp(Resource.IndexBuffer.BufferData);
+	TArray<FMeshletBuffer> Meshlets = TakeMeshlets(Resource.LODs);
+	TArray<uint16> ShortIndices;
+
+	Writer.AddMeta(Resource);
+	for (int32 i = 0; i < VertexData.Num(); ++i)
+	{
+		Writer.AddBlob(EMappedSection::VertexData, Resource.VertexBuffers[i].Stride, VertexData[i].GetData(), VertexData[i].Num());
+	}
+	AddIndexBlob(Writer, Resource.IndexBuffer.IndexWidth, IndexData, ShortIndices);
+	AddMeshletBlobs(Writer, Meshlets);
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	RestoreMeshlets(Resource.LODs, Meshlets);
+
+	for (int32 i = 0; i < VertexData.Num(); ++i)
+	{
+		Resource.VertexBuffers[i].RawData = MoveTemp(VertexData[i]);
+	}
+	Resource.IndexBuffer.BufferData = MoveTemp(IndexData);
+	return bOk;
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FSkeletalMeshResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<TArray<uint8>> VertexData;
+	VertexData.Reserve(Resource.VertexBuffers.Num());
+	for (FVertexBuffer& VertexBuffer : Resource.VertexBuffers)
+	{
+		VertexData.Add(MoveTemp(VertexBuffer.RawData));
+	}
+	TArray<TArray<uint8>> SkinWeights;
+	SkinWeights.Reserve(Resource.SkinWeightBuffers.Num());
+	for (FSkinWeightBuffer& SkinWeightBuffer : Resource.SkinWeightBuffers)
+	{
+		SkinWeights.Add(MoveTemp(SkinWeightBuffer.RawData));
+	}
+	TArray<uint32> IndexData = MoveTemp(Resource.IndexBuffer.BufferData);
+	TArray<FMeshletBuffer> Meshlets = TakeMeshlets(Resource.LODs);
+	TArray<uint16> ShortIndices;
+
+	Writer.AddMeta(Resource);
+	for (int32 i = 0; i < VertexData.Num(); ++i)
+	{
+		Writer.AddBlob(EMappedSection::VertexData, Resource.VertexBuffers[i].Stride, VertexData[i].GetData(), VertexData[i].Num());
+	}
+	AddIndexBlob(Writer, Resource.IndexBuffer.IndexWidth, IndexData, ShortIndices);
+	for (int32 i = 0; i < SkinWeights.Num(); ++i)
+	{
+		Writer.AddBlob(EMappedSection::SkinWeights, Resource.SkinWeightBuffers[i].GetStride(), SkinWeights[i].GetData(), SkinWeights[i].Num());
+	}
+	AddMeshletBlobs(Writer, Meshlets);
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	RestoreMeshlets(Resource.LODs, Meshlets);
+
+	for (int32 i = 0; i < VertexData.Num(); ++i)
+	{
+		Resource.VertexBuffers[i].RawData = MoveTemp(VertexData[i]);
+	}
+	for (int32 i = 0; i < SkinWeights.Num(); ++i)
+	{
+		Resource.SkinWeightBuffers[i].RawData = MoveTemp(SkinWeights[i]);
+	}
+	Resource.IndexBuffer.BufferData = MoveTemp(IndexData);
+	return bOk;
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FAnimSequenceResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<FAnimSequenceResource::FTrack> Tracks = MoveTemp(Resource.RawAnimationData);
+	TArray<FMatrix3x4> BakedMatrices = MoveTemp(Resource.BakedMatrices);
+
+	// keys of all tracks are written back to back, straight from the track arrays,
+	// compressed animations have no raw tracks and keep their keys in the meta stream
+	TArray<FMappedAnimTrack> TrackTable;
+	TArray<FBlobPiece> PosKeys;
+	TArray<FBlobPiece> RotKeys;
+	TArray<FBlobPiece> ScaleKeys;
+	uint32 NumPosKeys = 0;
+	uint32 NumRotKeys = 0;
+	uint32 NumScaleKeys = 0;
+	for (const FAnimSequenceResource::FTrack& Track : Tracks)
+	{
+		FMappedAnimTrack& Entry = TrackTable.AddZeroed_GetRef();
+		Entry.FirstPosKey = NumPosKeys;
+		Entry.NumPosKeys = Track.PosKeys.Num();
+		Entry.FirstRotKey = NumRotKeys;
+		Entry.NumRotKeys = Track.RotKeys.Num();
+		Entry.FirstScaleKey = NumScaleKeys;
+		Entry.NumScaleKeys = Track.ScaleKeys.Num();
+		NumPosKeys += Entry.NumPosKeys;
+		NumRotKeys += Entry.NumRotKeys;
+		NumScaleKeys += Entry.NumScaleKeys;
+		PosKeys.Add({ Track.PosKeys.GetData(), Track.PosKeys.Num() * sizeof(FVector) });
+		RotKeys.Add({ Track.RotKeys.GetData(), Track.RotKeys.Num() * sizeof(FQuat) });
+		ScaleKeys.Add({ Track.ScaleKeys.GetData(), Track.ScaleKeys.Num() * sizeof(FVector) });
+	}
+
+	Writer.AddMeta(Resource);
+	Writer.AddBlob(EMappedSection::AnimTracks, sizeof(FMappedAnimTrack), TrackTable.GetData(), TrackTable.Num() * sizeof(FMappedAnimTrack));
+	Writer.AddBlob(EMappedSection::AnimPosKeys, sizeof(FVector), MoveTemp(PosKeys));
+	Writer.AddBlob(EMappedSection::AnimRotKeys, sizeof(FQuat), MoveTemp(RotKeys));
+	Writer.AddBlob(EMappedSection::AnimScaleKeys, sizeof(FVector), MoveTemp(ScaleKeys));
+	Writer.AddBlob(EMappedSection::AnimBakedMatrices, sizeof(FMatrix3x4), BakedMatrices.GetData(), BakedMatrices.Num() * sizeof(FMatrix3x4));
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	Resource.RawAnimationData = MoveTemp(Tracks);
+	Resource.BakedMatrices = MoveTemp(BakedMatrices);
+	return bOk;
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FSkeleton& Resource)
+{
+	FMappedWriter Writer;
+	Writer.AddMeta(Resource);
+	return Writer.Write(Ar, Resource.Type);
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FVertexAnimationResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<uint16> PositionDeltas = MoveTemp(Resource.PositionDeltas);
+	TArray<uint16> NormalDeltas = MoveTemp(Resource.NormalDeltas);
+
+	Writer.AddMeta(Resource);
+	Writer.AddBlob(EMappedSection::VertexAnimPositions, 4 * sizeof(uint16), PositionDeltas.GetData(), PositionDeltas.Num() * sizeof(uint16));
+	Writer.AddBlob(EMappedSection::VertexAnimNormals, 4 * sizeof(uint16), NormalDeltas.GetData(), NormalDeltas.Num() * sizeof(uint16));
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	Resource.PositionDeltas = MoveTemp(PositionDeltas);
+	Resource.NormalDeltas = MoveTemp(NormalDeltas);
+	return bOk;
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FTextureResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<TArray<uint8>> MipData;
+	for (FTextureMip& Mip : Resource.Mips)
+	{
+		MipData.Add(MoveTemp(Mip.Data));
+	}
+
+	Writer.AddMeta(Resource);
+	for (const TArray<uint8>& Data : MipData)
+	{
+		Writer.AddBlob(EMappedSection::TextureMips, 1, Data.GetData(), Data.Num());
+	}
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	for (int32 i = 0; i < MipData.Num(); ++i)
+	{
+		Resource.Mips[i].Data = MoveTemp(MipData[i]);
+	}
+	return bOk;
+}
+
+bool ns_yoyo::WriteMappedResource(FArchive& Ar, FLevelResource& Resource)
+{
+	FMappedWriter Writer;
+	TArray<FStaticMeshInstanceGroup>& Groups = Resource.SceneInfo.StaticMeshInstanceGroups;
+
+	// transforms of all groups back to back, so each group loads with one copy per array
+	TArray<FMappedInstanceGroup> GroupTable;
+	TArray<FBlobPiece> Rotations;
+	TArray<FBlobPiece> Translations;
+	TArray<FBlobPiece> Scales;
+	TArray<FBlobPiece> Bounds;
+	TArray<FStaticMeshInstanceGroup> MovedGroups;
+	MovedGroups.Reserve(Groups.Num());
+	uint32 NumInstances = 0;
+	for (FStaticMeshInstanceGroup& Group : Groups)
+	{
+		FMappedInstanceGroup& Entry = GroupTable.AddZeroed_GetRef();
+		Entry.ResourceIndex = Group.ResourceIndex;
+		Entry.FirstInstance = NumInstances;
+		Entry.NumInstances = Group.GetNumInstances();
+		NumInstances += Entry.NumInstances;
+
+		// the meta stream keeps the resource index of every group, the arrays are emptied
+		FStaticMeshInstanceGroup& Moved = MovedGroups.Add_GetRef(MoveTemp(Group));
+		Group.ResourceIndex = Moved.ResourceIndex;
+		Rotations.Add({ Moved.Rotations.GetData(), Moved.Rotations.Num() * sizeof(FQuat) });
+		Translations.Add({ Moved.Translations.GetData(), Moved.Translations.Num() * sizeof(FVector) });
+		Scales.Add({ Moved.Scales.GetData(), Moved.Scales.Num() * sizeof(FVector) });
+		Bounds.Add({ Moved.Bounds.GetData(), Moved.Bounds.Num() * sizeof(FAABB) });
+	}
+	FSceneBVH BVH = MoveTemp(Resource.SceneInfo.StaticMeshBVH);
+
+	Writer.AddMeta(Resource);
+	Writer.AddBlob(EMappedSection::InstanceGroups, sizeof(FMappedInstanceGroup), GroupTable.GetData(), GroupTable.Num() * sizeof(FMappedInstanceGroup));
+	Writer.AddBlob(EMappedSection::InstanceRotations, sizeof(FQuat), MoveTemp(Rotations));
+	Writer.AddBlob(EMappedSection::InstanceTranslations, sizeof(FVector), MoveTemp(Translations));
+	Writer.AddBlob(EMappedSection::InstanceScales, sizeof(FVector), MoveTemp(Scales));
+	Writer.AddBlob(EMappedSection::InstanceBounds, sizeof(FAABB), MoveTemp(Bounds));
+	Writer.AddBlob(EMappedSection::BVHNodes, sizeof(FBVHNode), BVH.Nodes.GetData(), BVH.Nodes.Num() * sizeof(FBVHNode));
+	Writer.AddBlob(EMappedSection::BVHInstanceIndices, sizeof(uint32), BVH.InstanceIndices.GetData(), BVH.InstanceIndices.Num() * sizeof(uint32));
+	bool bOk = Writer.Write(Ar, Resource.Type);
+
+	Groups = MoveTemp(MovedGroups);
+	Resource.SceneInfo.StaticMeshBVH = MoveTemp(BVH);
+	return bOk;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Memory mappable variant of the resource files.
+	*
+	* FMappedHeader
+	* FMappedSection[NumSections]
+	* blobs, each starting at a 16 byte aligned file offset
+	*
+	* The Meta blob is the regular operator<< stream of the resource with the large arrays
+	* left empty, those arrays live in their own blobs so a loader can mmap the file and hand
+	* the pointers straight to the upload path. Type stays the first byte, a loader tells the
+	* two variants apart by the magic that follows it.
+	*/
+	constexpr uint32 MappedMagic = 0x504D5959; // "YYMP"
+	constexpr uint32 MappedAlignment = 16;
+
+	enum class EMappedSection : uint32
+	{
+		Meta,
+		// FVertexBuffer::RawData, one section per vertex buffer in order
+		VertexData,
+		// FIndexBuffer::BufferData, IndexWidth bytes per index
+		IndexData,
+		// FSkinWeightBuffer::RawData, one section per skin weight buffer in order
+		SkinWeights,
+		// FMappedAnimTrack per track
+		AnimTracks,
+		// every track's keys back to back, FVector/FQuat/FVector
+		AnimPosKeys,
+		AnimRotKeys,
+		AnimScaleKeys,
+		// FMappedInstanceGroup per static mesh instance group, empty for ESceneEncoding::Components
+		// and Matrices scenes, whose columns stay 16 byte aligned within the Meta blob
+		InstanceGroups,
+		// every group's instances back to back, FQuat/FVector/FVector/FAABB
+		InstanceRotations,
+		InstanceTranslations,
+		InstanceScales,
+		InstanceBounds,
+		// FSceneBVH::Nodes and FSceneBVH::InstanceIndices
+		BVHNodes,
+		BVHInstanceIndices,
+		// FMeshletBuffer::Meshlets/Vertices/Triangles, one section of each per LOD in order,
+		// none when the meshlets weren't built
+		Meshlets,
+		MeshletVertices,
+		MeshletTriangles,
+		// FAnimSequenceResource::BakedMatrices, empty when none were baked
+		AnimBakedMatrices,
+		// FVertexAnimationResource::PositionDeltas/NormalDeltas, 4 halves per texel
+		VertexAnimPositions,
+		VertexAnimNormals,
+		// FTextureMip::Data, one section per mip in order
+		TextureMips,
+		Max
+	};
+
+	struct FMappedHeader
+	{
+		EResourceType Type;
+		uint8 Pad[3];
+		uint32 Magic;
+		uint32 FormatVersion;
+		uint32 NumSections;
+	};
+	static_assert(sizeof(FMappedHeader) == 16, "FMappedHeader must stay 16 bytes");
+
+	struct FMappedSection
+	{
+		EMappedSection Id;
+		// bytes per element, 1 for untyped data
+		uint32 ElementSize;
+		// from the start of the file
+		uint64 Offset;
+		uint64 Size;
+	};
+	static_assert(sizeof(FMappedSection) == 24, "FMappedSection must stay 24 bytes");
+
+	// element offsets into the AnimPosKeys/AnimRotKeys/AnimScaleKeys blobs
+	struct FMappedAnimTrack
+	{
+		uint32 FirstPosKey;
+		uint32 NumPosKeys;
+		uint32 FirstRotKey;
+		uint32 NumRotKeys;
+		uint32 FirstScaleKey;
+		uint32 NumScaleKeys;
+	};
+
+	// element offsets into the InstanceRotations/InstanceTranslations/InstanceScales blobs
+	struct FMappedInstanceGroup
+	{
+		int32 ResourceIndex;
+		uint32 FirstInstance;
+		uint32 NumInstances;
+	};
+
+	bool WriteMappedResource(FArchive& Ar, FStaticMeshResource& Resource);
+	bool WriteMappedResource(FArchive& Ar, FSkeletalMeshResource& Resource);
+	bool WriteMappedResource(FArchive& Ar, FAnimSequenceResource& Resource);
+	bool WriteMappedResource(FArchive& Ar, FSkeleton& Resource);
+	bool WriteMappedResource(FArchive& Ar, FVertexAnimationResource& Resource);
+	bool WriteMappedResource(FArchive& Ar, FTextureResource& Resource);
+	bool WriteMappedResource(FArchive& Ar, FLevelResource& Resource);
+}
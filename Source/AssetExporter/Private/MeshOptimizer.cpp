@@ -0,0 +1,460 @@
+#include "MeshOptimizer.h"
+#include "ExportTypes.h"
+
+namespace
+{
+	// tuning from the paper
+	constexpr int32 ForsythCacheSize = 32;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	float GetVertexScore(int32 CachePosition, uint32 NumActiveTriangles)
+	{
+		if (NumActiveTriangles == 0)
+		{
+			// nothing left to draw with this vertex
+			return -1.f;
+		}
+		float Score = 0.f;
+		if (CachePosition >= 0)
+		{
+			if (CachePosition < 3)
+			{
+				// used by the last triangle, fixed score so the next one doesn't just reuse the same edge
+				Score = LastTriScore;
+			}
+			else
+			{
+				const float Scaler = 1.f / (ForsythCacheSize - 3);
+				Score = FMath::Pow(1.f - (CachePosition - 3) * Scaler, CacheDecayPower);
+			}
+		}
+		// favor vertices with few triangles left, to get rid of lone triangles early
+		Score += ValenceBoostScale * FMath::Pow((float)NumActiveTriangles, -ValenceBoostPower);
+		return Score;
+	}
+}
+
+ns_yoyo::FVertexCacheStats ns_yoyo::AnalyzeVertexCache(const TArray<uint32>& Indices, uint32 NumVertices, uint32 CacheSize)
+{
+	FVertexCacheStats Stats;
+	if (Indices.Num() < 3)
+	{
+		return Stats;
+	}
+
+	// FIFO simulation, a vertex is cached while fewer than CacheSize misses happened since it was loaded
+	TArray<uint32> LoadTime;
+	LoadTime.SetNumZeroed(NumVertices);
+	uint32 Time = CacheSize + 1;
+	uint32 NumMisses = 0;
+	uint32 NumUsedVertices = 0;
+	for (uint32 Index : Indices)
+	{
+		check(Index < NumVertices);
+		if (Time - LoadTime[Index] > CacheSize)
+		{
+			NumUsedVertices += LoadTime[Index] == 0 ? 1 : 0;
+			LoadTime[Index] = Time++;
+			++NumMisses;
+		}
+	}
+	Stats.ACMR = (float)NumMisses / (Indices.Num() / 3);
+	Stats.ATVR = (float)NumMisses / FMath::Max(NumUsedVertices, 1u);
+	return Stats;
+}
+
+void ns_yoyo::OptimizeVertexCache(uint32* Indices, uint32 NumIndices)
+{
+	const uint32 NumTriangles = NumIndices / 3;
+	if (NumTriangles < 2)
+	{
+		return;
+	}
+
+	// work on vertex ids local to the referenced range
+	uint32 MinIndex = MAX_uint32;
+	uint32 MaxIndex = 0;
+	for (uint32 i = 0; i < NumIndices; ++i)
+	{
+		MinIndex = FMath::Min(MinIndex, Indices[i]);
+		MaxIndex = FMath::Max(MaxIndex, Indices[i]);
+	}
+	const uint32 NumVertices = MaxIndex - MinIndex + 1;
+	auto LocalVertex = [Indices, MinIndex](uint32 Corner) { return Indices[Corner] - MinIndex; };
+
+	// triangles of every vertex, the first NumActiveTriangles of a vertex's list are not emitted yet
+	TArray<uint32> NumActiveTriangles;
+	NumActiveTriangles.SetNumZeroed(NumVertices);
+	for (uint32 Corner = 0; Corner < NumIndices; ++Corner)
+	{
+		++NumActiveTriangles[LocalVertex(Corner)];
+	}
+	TArray<uint32> TriangleListStart;
+	TriangleListStart.SetNumUninitialized(NumVertices);
+	uint32 Offset = 0;
+	for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		TriangleListStart[Vertex] = Offset;
+		Offset += NumActiveTriangles[Vertex];
+	}
+	TArray<uint32> VertexTriangles;
+	VertexTriangles.SetNumUninitialized(NumIndices);
+	{
+		TArray<uint32> Cursor = TriangleListStart;
+		for (uint32 Corner = 0; Corner < NumIndices; ++Corner)
+		{
+			VertexTriangles[Cursor[LocalVertex(Corner)]++] = Corner / 3;
+		}
+	}
+
+	TArray<int32> CachePosition;
+	CachePosition.Init(INDEX_NONE, NumVertices);
+	TArray<float> VertexScores;
+	VertexScores.SetNumUninitialized(NumVertices);
+	for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		VertexScores[Vertex] = GetVertexScore(INDEX_NONE, NumActiveTriangles[Vertex]);
+	}
+
+	auto GetTriangleScore = [&VertexScores, &LocalVertex](uint32 Triangle)
+	{
+		return VertexScores[LocalVertex(Triangle * 3)]
+			+ VertexScores[LocalVertex(Triangle * 3 + 1)]
+			+ VertexScores[LocalVertex(Triangle * 3 + 2)];
+	};
+	TArray<bool> bEmitted;
+	bEmitted.Init(false, NumTriangles);
+	uint32 BestTriangle = 0;
+	float BestScore = GetTriangleScore(0);
+	for (uint32 Triangle = 1; Triangle < NumTriangles; ++Triangle)
+	{
+		const float Score = GetTriangleScore(Triangle);
+		if (Score > BestScore)
+		{
+			BestScore = Score;
+			BestTriangle = Triangle;
+		}
+	}
+
+	TArray<uint32> NewIndices;
+	NewIndices.SetNumUninitialized(NumIndices);
+	uint32 Cache[ForsythCacheSize + 3];
+	int32 CacheCount = 0;
+	uint32 NextUnemitted = 0;
+	for (uint32 NumEmitted = 0; NumEmitted < NumTriangles; ++NumEmitted)
+	{
+		if (BestTriangle == MAX_uint32)
+		{
+			// nothing in the cache has triangles left, continue with any triangle
+			while (bEmitted[NextUnemitted])
+			{
+				++NextUnemitted;
+			}
+			BestTriangle = NextUnemitted;
+		}
+
+		uint32 TriangleVertices[3];
+		for (uint32 Corner = 0; Corner < 3; ++Corner)
+		{
+			NewIndices[NumEmitted * 3 + Corner] = Indices[BestTriangle * 3 + Corner];
+			TriangleVertices[Corner] = LocalVertex(BestTriangle * 3 + Corner);
+		}
+		bEmitted[BestTriangle] = true;
+
+		// drop the triangle from its vertices' active lists
+		for (uint32 Vertex : TriangleVertices)
+		{
+			uint32* List = &VertexTriangles[TriangleListStart[Vertex]];
+			const uint32 NumActive = NumActiveTriangles[Vertex];
+			for (uint32 i = 0; i < NumActive; ++i)
+			{
+				if (List[i] == BestTriangle)
+				{
+					Swap(List[i], List[NumActive - 1]);
+					--NumActiveTriangles[Vertex];
+					break;
+				}
+			}
+		}
+
+		// the triangle's vertices move to the front of the cache
+		uint32 NewCache[ForsythCacheSize + 3];
+		int32 NewCacheCount = 0;
+		for (uint32 Vertex : TriangleVertices)
+		{
+			bool bAdded = false;
+			for (int32 i = 0; i < NewCacheCount; ++i)
+			{
+				bAdded |= NewCache[i] == Vertex;
+			}
+			if (!bAdded)
+			{
+				NewCache[NewCacheCount++] = Vertex;
+			}
+		}
+		for (int32 i = 0; i < CacheCount; ++i)
+		{
+			const uint32 Vertex = Cache[i];
+			if (Vertex != TriangleVertices[0] && Vertex != TriangleVertices[1] && Vertex != TriangleVertices[2])
+			{
+				NewCache[NewCacheCount++] = Vertex;
+			}
+		}
+
+		// rescore everything that moved, including vertices pushed out of the cache
+		for (int32 i = 0; i < NewCacheCount; ++i)
+		{
+			const uint32 Vertex = NewCache[i];
+			CachePosition[Vertex] = i < ForsythCacheSize ? i : INDEX_NONE;
+			VertexScores[Vertex] = GetVertexScore(CachePosition[Vertex], NumActiveTriangles[Vertex]);
+		}
+		BestTriangle = MAX_uint32;
+		BestScore = -1.f;
+		for (int32 i = 0; i < NewCacheCount; ++i)
+		{
+			const uint32 Vertex = NewCache[i];
+			const uint32* List = &VertexTriangles[TriangleListStart[Vertex]];
+			for (uint32 j = 0; j < NumActiveTriangles[Vertex]; ++j)
+			{
+				const uint32 Triangle = List[j];
+				const float Score = GetTriangleScore(Triangle);
+				if (Score > BestScore)
+				{
+					BestScore = Score;
+					BestTriangle = Triangle;
+				}
+			}
+		}
+
+		CacheCount = FMath::Min(NewCacheCount, ForsythCacheSize);
+		FMemory::Memcpy(Cache, NewCache, CacheCount * sizeof(uint32));
+	}
+
+	FMemory::Memcpy(Indices, NewIndices.GetData(), NumIndices * sizeof(uint32));
+}
+
+void ns_yoyo::OptimizeMeshSections(TArray<uint32>& Indices, const TArray<FMeshSectionRange>& Sections,
+	uint32 NumVertices, TArray<uint32>& OutVertexRemap)
+{
+	for (const FMeshSectionRange& Section : Sections)
+	{
+		check(Section.FirstIndex + Section.NumTriangles * 3 <= (uint32)Indices.Num());
+		OptimizeVertexCache(Indices.GetData() + Section.FirstIndex, Section.NumTriangles * 3);
+	}
+
+	// vertices may only be moved when every section owns its vertex range
+	OutVertexRemap.Reset();
+	TArray<FMeshSectionRange> SortedSections = Sections;
+	SortedSections.Sort([](const FMeshSectionRange& A, const FMeshSectionRange& B) { return A.FirstVertex < B.FirstVertex; });
+	for (int32 i = 0; i < SortedSections.Num(); ++i)
+	{
+		const FMeshSectionRange& Section = SortedSections[i];
+		const uint32 EndVertex = Section.FirstVertex + Section.NumVertices;
+		if (EndVertex > NumVertices
+			|| (i + 1 < SortedSections.Num() && EndVertex > SortedSections[i + 1].FirstVertex))
+		{
+			return;
+		}
+		for (uint32 Corner = 0; Corner < Section.NumTriangles * 3; ++Corner)
+		{
+			const uint32 Index = Indices[Section.FirstIndex + Corner];
+			if (Index < Section.FirstVertex || Index >= EndVertex)
+			{
+				return;
+			}
+		}
+	}
+
+	// first use order inside every section, unused vertices go to the end of their range
+	OutVertexRemap.SetNumUninitialized(NumVertices);
+	for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		OutVertexRemap[Vertex] = Vertex;
+	}
+	for (const FMeshSectionRange& Section : Sections)
+	{
+		const uint32 EndVertex = Section.FirstVertex + Section.NumVertices;
+		for (uint32 Vertex = Section.FirstVertex; Vertex < EndVertex; ++Vertex)
+		{
+			OutVertexRemap[Vertex] = MAX_uint32;
+		}
+		uint32 NextVertex = Section.FirstVertex;
+		for (uint32 Corner = 0; Corner < Section.NumTriangles * 3; ++Corner)
+		{
+			uint32& NewVertex = OutVertexRemap[Indices[Section.FirstIndex + Corner]];
+			if (NewVertex == MAX_uint32)
+			{
+				NewVertex = NextVertex++;
+			}
+		}
+		for (uint32 Vertex = Section.FirstVertex; Vertex < EndVertex; ++Vertex)
+		{
+			if (OutVertexRemap[Vertex] == MAX_uint32)
+			{
+				OutVertexRemap[Vertex] = NextVertex++;
+			}
+		}
+	}
+	for (uint32& Index : Indices)
+	{
+		Index = OutVertexRemap[Index];
+	}
+}
+
+void ns_yoyo::RemapVertexData(uint8* Data, uint32 Stride, const TArray<uint32>& VertexRemap)
+{
+	TArray<uint8> OldData;
+	OldData.SetNumUninitialized(VertexRemap.Num() * Stride);
+	FMemory::Memcpy(OldData.GetData(), Data, OldData.Num());
+	for (int32 OldVertex = 0; OldVertex < VertexRemap.Num(); ++OldVertex)
+	{
+		FMemory::Memcpy(Data + VertexRemap[OldVertex] * Stride, OldData.GetData() + OldVertex * Stride, Stride);
+	}
+}
+
+namespace
+{
+	// the index range of one LOD and its sections, FirstIndex of the sections relative to the whole index buffer
+	struct FLODIndexRange
+	{
+		uint32 FirstIndex = 0;
+		uint32 NumIndices = 0;
+		TArray<ns_yoyo::FMeshSectionRange> Sections;
+	};
+
+	/*
+	* Optimizes every LOD drawing from one vertex buffer in a single pass, so one vertex remap
+	* fits all of them. The sections of LODs sharing a buffer overlap, in that case only
+	* their triangles are reordered.
+	*/
+	void OptimizeVertexBufferLODs(TArray<uint32>& Indices, const TArray<FLODIndexRange>& LODs, uint32 NumVertices,
+		TArray<uint32>& OutVertexRemap)
+	{
+		TArray<uint32> BufferIndices;
+		TArray<ns_yoyo::FMeshSectionRange> Sections;
+		for (const FLODIndexRange& LOD : LODs)
+		{
+			const uint32 Offset = BufferIndices.Num();
+			BufferIndices.Append(Indices.GetData() + LOD.FirstIndex, LOD.NumIndices);
+			for (ns_yoyo::FMeshSectionRange Section : LOD.Sections)
+			{
+				Section.FirstIndex = Section.FirstIndex - LOD.FirstIndex + Offset;
+				Sections.Add(Section);
+			}
+		}
+
+		ns_yoyo::OptimizeMeshSections(BufferIndices, Sections, NumVertices, OutVertexRemap);
+
+		uint32 Offset = 0;
+		for (const FLODIndexRange& LOD : LODs)
+		{
+			FMemory::Memcpy(Indices.GetData() + LOD.FirstIndex, BufferIndices.GetData() + Offset, LOD.NumIndices * sizeof(uint32));
+			Offset += LOD.NumIndices;
+		}
+	}
+
+	ns_yoyo::FVertexCacheStats AnalyzeLODVertexCache(const TArray<uint32>& Indices, uint32 FirstIndex, uint32 NumIndices, uint32 NumVertices)
+	{
+		TArray<uint32> LODIndices;
+		LODIndices.Append(Indices.GetData() + FirstIndex, NumIndices);
+		return ns_yoyo::AnalyzeVertexCache(LODIndices, NumVertices);
+	}
+}
+
+void ns_yoyo::OptimizeStaticMesh(FStaticMeshResource& Resource, FVertexCacheStats& OutBefore, FVertexCacheStats& OutAfter)
+{
+	if (Resource.LODs.Num() == 0)
+	{
+		return;
+	}
+	const FStaticMeshLOD& LOD0 = Resource.LODs[0];
+	const uint32 LOD0Vertices = Resource.VertexBuffers[LOD0.VertexBufferIndex].NumVertices;
+	OutBefore = AnalyzeLODVertexCache(Resource.IndexBuffer.BufferData, LOD0.FirstIndex, LOD0.NumIndices, LOD0Vertices);
+
+	for (int32 BufferIndex = 0; BufferIndex < Resource.VertexBuffers.Num(); ++BufferIndex)
+	{
+		FVertexBuffer& VertexBuffer = Resource.VertexBuffers[BufferIndex];
+		TArray<FLODIndexRange> LODs;
+		for (const FStaticMeshLOD& LOD : Resource.LODs)
+		{
+			if (LOD.VertexBufferIndex != BufferIndex)
+			{
+				continue;
+			}
+			FLODIndexRange& LODRange = LODs.AddDefaulted_GetRef();
+			LODRange.FirstIndex = LOD.FirstIndex;
+			LODRange.NumIndices = LOD.NumIndices;
+			for (const FStaticMeshSection& Section : LOD.Sections)
+			{
+				if (Section.NumTriangles > 0)
+				{
+					FMeshSectionRange& Range = LODRange.Sections.AddDefaulted_GetRef();
+					Range.FirstIndex = Section.FirstIndex;
+					Range.NumTriangles = Section.NumTriangles;
+					Range.FirstVertex = Section.MinVertexIndex;
+					Range.NumVertices = Section.MaxVertexIndex - Section.MinVertexIndex + 1;
+				}
+			}
+		}
+
+		TArray<uint32> VertexRemap;
+		OptimizeVertexBufferLODs(Resource.IndexBuffer.BufferData, LODs, VertexBuffer.NumVertices, VertexRemap);
+		if (VertexRemap.Num() > 0)
+		{
+			RemapVertexData(VertexBuffer.RawData.GetData(), VertexBuffer.Stride, VertexRemap);
+		}
+	}
+	OutAfter = AnalyzeLODVertexCache(Resource.IndexBuffer.BufferData, LOD0.FirstIndex, LOD0.NumIndices, LOD0Vertices);
+}
+
+void ns_yoyo::OptimizeSkeletalMesh(FSkeletalMeshResource& Resource, FVertexCacheStats& OutBefore, FVertexCacheStats& OutAfter)
+{
+	if (Resource.LODs.Num() == 0)
+	{
+		return;
+	}
+	const FSkeletalMeshLOD& LOD0 = Resource.LODs[0];
+	const uint32 LOD0Vertices = Resource.VertexBuffers[LOD0.VertexBufferIndex].NumVertices;
+	OutBefore = AnalyzeLODVertexCache(Resource.IndexBuffer.BufferData, LOD0.FirstIndex, LOD0.NumIndices, LOD0Vertices);
+
+	for (int32 BufferIndex = 0; BufferIndex < Resource.VertexBuffers.Num(); ++BufferIndex)
+	{
+		FVertexBuffer& VertexBuffer = Resource.VertexBuffers[BufferIndex];
+		TArray<FLODIndexRange> LODs;
+		for (const FSkeletalMeshLOD& LOD : Resource.LODs)
+		{
+			if (LOD.VertexBufferIndex != BufferIndex)
+			{
+				continue;
+			}
+			FLODIndexRange& LODRange = LODs.AddDefaulted_GetRef();
+			LODRange.FirstIndex = LOD.FirstIndex;
+			LODRange.NumIndices = LOD.NumIndices;
+			for (const FSkelMeshRenderSection& Section : LOD.RenderSections)
+			{
+				if (Section.NumTriangles > 0)
+				{
+					FMeshSectionRange& Range = LODRange.Sections.AddDefaulted_GetRef();
+					Range.FirstIndex = Section.BaseIndex;
+					Range.NumTriangles = Section.NumTriangles;
+					Range.FirstVertex = Section.BaseVertexIndex;
+					Range.NumVertices = Section.NumVertices;
+				}
+			}
+		}
+
+		TArray<uint32> VertexRemap;
+		OptimizeVertexBufferLODs(Resource.IndexBuffer.BufferData, LODs, VertexBuffer.NumVertices, VertexRemap);
+		if (VertexRemap.Num() > 0)
+		{
+			RemapVertexData(VertexBuffer.RawData.GetData(), VertexBuffer.Stride, VertexRemap);
+			// skin weights are per vertex too
+			FSkinWeightBuffer& SkinWeightBuffer = Resource.SkinWeightBuffers[BufferIndex];
+			RemapVertexData(SkinWeightBuffer.RawData.GetData(), SkinWeightBuffer.GetStride(), VertexRemap);
+		}
+	}
+	OutAfter = AnalyzeLODVertexCache(Resource.IndexBuffer.BufferData, LOD0.FirstIndex, LOD0.NumIndices, LOD0Vertices);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace ns_yoyo
+{
+	struct FStaticMeshResource;
+	struct FSkeletalMeshResource;
+
+	// a section of a mesh: a range of triangles referencing a range of vertices
+	struct FMeshSectionRange
+	{
+		uint32 FirstIndex = 0;
+		uint32 NumTriangles = 0;
+		uint32 FirstVertex = 0;
+		uint32 NumVertices = 0;
+	};
+
+	struct FVertexCacheStats
+	{
+		// average cache miss ratio, transformed vertices per triangle, 0.5 is the best possible
+		float ACMR = 0.f;
+		// average transform to vertex ratio, 1.0 is the best possible
+		float ATVR = 0.f;
+	};
+
+	// size of the simulated FIFO post transform cache used by AnalyzeVertexCache
+	constexpr uint32 VertexCacheAnalyzeSize = 16;
+
+	FVertexCacheStats AnalyzeVertexCache(const TArray<uint32>& Indices, uint32 NumVertices,
+		uint32 CacheSize = VertexCacheAnalyzeSize);
+
+	// reorders the triangles of a triangle list for the post transform cache, after Tom Forsyth's
+	// "Linear-Speed Vertex Cache Optimisation"
+	void OptimizeVertexCache(uint32* Indices, uint32 NumIndices);
+
+	/*
+	* Reorders the triangles of every section for the vertex cache, then the vertices of every
+	* section in first use order for fetch locality. Vertices never leave their section's range.
+	* OutVertexRemap[Old] = New, left empty when the section vertex ranges overlap and only
+	* triangles were reordered.
+	*/
+	void OptimizeMeshSections(TArray<uint32>& Indices, const TArray<FMeshSectionRange>& Sections,
+		uint32 NumVertices, TArray<uint32>& OutVertexRemap);
+
+	// reorders fixed size vertex records, VertexRemap[Old] = New
+	void RemapVertexData(uint8* Data, uint32 Stride, const TArray<uint32>& VertexRemap);
+
+	template<typename T>
+	void RemapVertexData(TArray<T>& Data, const TArray<uint32>& VertexRemap)
+	{
+		check(Data.Num() == VertexRemap.Num());
+		RemapVertexData(reinterpret_cast<uint8*>(Data.GetData()), sizeof(T), VertexRemap);
+	}
+
+	// optimizes the index and vertex order of a whole mesh, returns the cache stats before and after
+	void OptimizeStaticMesh(FStaticMeshResource& Resource, FVertexCacheStats& OutBefore, FVertexCacheStats& OutAfter);
+	void OptimizeSkeletalMesh(FSkeletalMeshResource& Resource, FVertexCacheStats& OutBefore, FVertexCacheStats& OutAfter);
+}
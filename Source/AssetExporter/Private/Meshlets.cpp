@@ -0,0 +1,343 @@
+#include "Meshlets.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// cones wider than this can never cull, about 84 degrees from the axis
+	constexpr float MinConeDot = 0.1f;
+
+	// the same winding as the triangle normals of MeshUtilities
+	FVector GetTriangleNormal(const FVector& P0, const FVector& P1, const FVector& P2)
+	{
+		return ((P2 - P0) ^ (P1 - P0)).GetSafeNormal();
+	}
+
+	// bounding sphere around the box of the vertices and the normal cone of the triangles, after meshoptimizer
+	void ComputeMeshletBounds(ns_yoyo::FMeshlet& Meshlet, const ns_yoyo::FMeshletBuffer& Buffer, const TArray<FVector>& Positions)
+	{
+		const uint32* Vertices = Buffer.Vertices.GetData() + Meshlet.FirstVertex;
+		const uint8* Triangles = Buffer.Triangles.GetData() + Meshlet.FirstTriangle * 3;
+
+		ns_yoyo::FAABB Box;
+		for (uint32 i = 0; i < Meshlet.NumVertices; ++i)
+		{
+			Box += Positions[Vertices[i]];
+		}
+		Meshlet.BoundsCenter = Box.GetCenter();
+		float RadiusSquared = 0.f;
+		for (uint32 i = 0; i < Meshlet.NumVertices; ++i)
+		{
+			RadiusSquared = FMath::Max(RadiusSquared, FVector::DistSquared(Meshlet.BoundsCenter, Positions[Vertices[i]]));
+		}
+		Meshlet.BoundsRadius = FMath::Sqrt(RadiusSquared);
+
+		TArray<FVector, TInlineAllocator<128>> Normals;
+		FVector NormalSum = FVector::ZeroVector;
+		for (uint32 i = 0; i < Meshlet.NumTriangles; ++i)
+		{
+			const FVector& P0 = Positions[Vertices[Triangles[i * 3 + 0]]];
+			const FVector Normal = GetTriangleNormal(P0, Positions[Vertices[Triangles[i * 3 + 1]]], Positions[Vertices[Triangles[i * 3 + 2]]]);
+			// degenerate triangles face nowhere
+			Normals.Add(Normal);
+			NormalSum += Normal;
+		}
+		const FVector Axis = NormalSum.GetSafeNormal();
+		if (Axis.IsZero())
+		{
+			return;
+		}
+		float MinDot = 1.f;
+		for (const FVector& Normal : Normals)
+		{
+			if (!Normal.IsZero())
+			{
+				MinDot = FMath::Min(MinDot, Normal | Axis);
+			}
+		}
+		if (MinDot <= MinConeDot)
+		{
+			return;
+		}
+
+		// the apex sits behind the plane of every triangle, so the test holds for the whole meshlet
+		float MaxT = 0.f;
+		for (uint32 i = 0; i < Meshlet.NumTriangles; ++i)
+		{
+			if (!Normals[i].IsZero())
+			{
+				const FVector& P0 = Positions[Vertices[Triangles[i * 3]]];
+				MaxT = FMath::Max(MaxT, ((Meshlet.BoundsCenter - P0) | Normals[i]) / (Axis | Normals[i]));
+			}
+		}
+		Meshlet.ConeApex = Meshlet.BoundsCenter - Axis * MaxT;
+		Meshlet.ConeAxis = Axis;
+		Meshlet.ConeCutoff = FMath::Sqrt(1.f - MinDot * MinDot);
+	}
+
+	struct FSectionJob
+	{
+		int32 LODIndex;
+		int32 VertexBufferIndex;
+		uint32 SectionIndex;
+		uint32 FirstIndex;
+		uint32 NumTriangles;
+	};
+
+	// appends Src to Dest, rebasing the meshlet ranges
+	void AppendMeshlets(ns_yoyo::FMeshletBuffer& Dest, const ns_yoyo::FMeshletBuffer& Src)
+	{
+		const uint32 VertexOffset = Dest.Vertices.Num();
+		const uint32 TriangleOffset = Dest.Triangles.Num() / 3;
+		for (ns_yoyo::FMeshlet Meshlet : Src.Meshlets)
+		{
+			Meshlet.FirstVertex += VertexOffset;
+			Meshlet.FirstTriangle += TriangleOffset;
+			Dest.Meshlets.Add(Meshlet);
+		}
+		Dest.Vertices.Append(Src.Vertices);
+		Dest.Triangles.Append(Src.Triangles);
+	}
+
+	// one task per section, results appended in job order
+	void RunSectionJobs(const TArray<FSectionJob>& Jobs, const TArray<ns_yoyo::FVertexBuffer>& VertexBuffers,
+		const TArray<uint32>& Indices, const ns_yoyo::FMeshletSettings& Settings, TArray<ns_yoyo::FMeshletBuffer>& OutLODMeshlets)
+	{
+		TArray<TArray<FVector>> Positions;
+		Positions.SetNum(VertexBuffers.Num());
+		for (int32 i = 0; i < VertexBuffers.Num(); ++i)
+		{
+			VertexBuffers[i].GetPositions(Positions[i]);
+		}
+
+		TArray<ns_yoyo::FMeshletBuffer> JobMeshlets;
+		JobMeshlets.SetNum(Jobs.Num());
+		ParallelFor(Jobs.Num(), [&](int32 JobIndex)
+		{
+			const FSectionJob& Job = Jobs[JobIndex];
+			check(Job.FirstIndex + Job.NumTriangles * 3 <= (uint32)Indices.Num());
+			ns_yoyo::BuildMeshlets(Indices.GetData() + Job.FirstIndex, Job.NumTriangles, Positions[Job.VertexBufferIndex],
+				Job.SectionIndex, JobMeshlets[JobIndex], Settings);
+		});
+
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+		{
+			AppendMeshlets(OutLODMeshlets[Jobs[JobIndex].LODIndex], JobMeshlets[JobIndex]);
+		}
+	}
+}
+
+void ns_yoyo::BuildMeshlets(const uint32* Indices, uint32 NumTriangles, const TArray<FVector>& Positions, uint32 SectionIndex,
+	FMeshletBuffer& Out, const FMeshletSettings& Settings)
+{
+	check(Settings.MaxVertices >= 3 && Settings.MaxVertices <= 256 && Settings.MaxTriangles > 0);
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+
+	// section local vertex ids, in first use order
+	TMap<uint32, uint32> LocalIds;
+	LocalIds.Reserve(NumTriangles);
+	TArray<uint32> Vertices;
+	TArray<uint32> Corners;
+	Corners.SetNumUninitialized(NumTriangles * 3);
+	for (uint32 i = 0; i < NumTriangles * 3; ++i)
+	{
+		const uint32* Found = LocalIds.Find(Indices[i]);
+		Corners[i] = Found ? *Found : LocalIds.Add(Indices[i], Vertices.Add(Indices[i]));
+	}
+
+	// triangles around every vertex, in ascending order
+	const int32 NumVertices = Vertices.Num();
+	TArray<uint32> AdjacencyOffsets;
+	AdjacencyOffsets.SetNumZeroed(NumVertices + 1);
+	for (uint32 Corner : Corners)
+	{
+		++AdjacencyOffsets[Corner + 1];
+	}
+	for (int32 i = 0; i < NumVertices; ++i)
+	{
+		AdjacencyOffsets[i + 1] += AdjacencyOffsets[i];
+	}
+	TArray<uint32> AdjacentTriangles;
+	AdjacentTriangles.SetNumUninitialized(NumTriangles * 3);
+	{
+		TArray<uint32> Fill(AdjacencyOffsets.GetData(), NumVertices);
+		for (uint32 i = 0; i < NumTriangles * 3; ++i)
+		{
+			AdjacentTriangles[Fill[Corners[i]]++] = i / 3;
+		}
+	}
+
+	TArray<bool> Emitted;
+	Emitted.Init(false, NumTriangles);
+	// unused triangles around every vertex
+	TArray<uint32> LiveTriangles;
+	LiveTriangles.SetNumUninitialized(NumVertices);
+	for (int32 i = 0; i < NumVertices; ++i)
+	{
+		LiveTriangles[i] = AdjacencyOffsets[i + 1] - AdjacencyOffsets[i];
+	}
+	// position of a vertex in the current meshlet
+	TArray<int32> Slots;
+	Slots.Init(INDEX_NONE, NumVertices);
+	TArray<uint32> MeshletVertices;
+	TArray<uint8> MeshletTriangles;
+	// unused triangles around the current meshlet, may repeat
+	TArray<uint32> Candidates;
+
+	auto Flush = [&]()
+	{
+		FMeshlet& Meshlet = Out.Meshlets.AddDefaulted_GetRef();
+		Meshlet.FirstVertex = Out.Vertices.Num();
+		Meshlet.NumVertices = MeshletVertices.Num();
+		Meshlet.FirstTriangle = Out.Triangles.Num() / 3;
+		Meshlet.NumTriangles = MeshletTriangles.Num() / 3;
+		Meshlet.SectionIndex = SectionIndex;
+		for (uint32 Vertex : MeshletVertices)
+		{
+			Out.Vertices.Add(Vertices[Vertex]);
+			Slots[Vertex] = INDEX_NONE;
+		}
+		Out.Triangles.Append(MeshletTriangles);
+		if (Positions.Num() > 0)
+		{
+			ComputeMeshletBounds(Meshlet, Out, Positions);
+		}
+		MeshletVertices.Reset();
+		MeshletTriangles.Reset();
+		Candidates.Reset();
+	};
+
+	auto GetNumNewVertices = [&](uint32 Triangle)
+	{
+		return (Slots[Corners[Triangle * 3 + 0]] == INDEX_NONE ? 1u : 0u)
+			+ (Slots[Corners[Triangle * 3 + 1]] == INDEX_NONE ? 1u : 0u)
+			+ (Slots[Corners[Triangle * 3 + 2]] == INDEX_NONE ? 1u : 0u);
+	};
+
+	// vertices with few triangles left go first, that closes off the meshlet's border instead of stretching it
+	auto GetNumLiveTriangles = [&](uint32 Triangle)
+	{
+		return LiveTriangles[Corners[Triangle * 3 + 0]] + LiveTriangles[Corners[Triangle * 3 + 1]] + LiveTriangles[Corners[Triangle * 3 + 2]];
+	};
+
+	uint32 NextSeed = 0;
+	for (uint32 NumEmitted = 0; NumEmitted < NumTriangles;)
+	{
+		int32 Best = INDEX_NONE;
+		uint32 BestNewVertices = MAX_uint32;
+		uint32 BestLiveTriangles = MAX_uint32;
+		if (MeshletTriangles.Num() == 0)
+		{
+			while (Emitted[NextSeed])
+			{
+				++NextSeed;
+			}
+			Best = NextSeed;
+			BestNewVertices = GetNumNewVertices(NextSeed);
+		}
+		else
+		{
+			int32 NumCandidates = 0;
+			for (uint32 Triangle : Candidates)
+			{
+				if (Emitted[Triangle])
+				{
+					continue;
+				}
+				Candidates[NumCandidates++] = Triangle;
+				const uint32 NewVertices = GetNumNewVertices(Triangle);
+				const uint32 NumLive = GetNumLiveTriangles(Triangle);
+				if (NewVertices < BestNewVertices
+					|| (NewVertices == BestNewVertices && (NumLive < BestLiveTriangles
+						|| (NumLive == BestLiveTriangles && (int32)Triangle < Best))))
+				{
+					Best = Triangle;
+					BestNewVertices = NewVertices;
+					BestLiveTriangles = NumLive;
+				}
+			}
+			Candidates.SetNum(NumCandidates, false);
+		}
+
+		if (Best == INDEX_NONE || MeshletVertices.Num() + BestNewVertices > Settings.MaxVertices)
+		{
+			Flush();
+			continue;
+		}
+
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			const uint32 Vertex = Corners[Best * 3 + k];
+			if (Slots[Vertex] == INDEX_NONE)
+			{
+				Slots[Vertex] = MeshletVertices.Add(Vertex);
+				for (uint32 i = AdjacencyOffsets[Vertex]; i < AdjacencyOffsets[Vertex + 1]; ++i)
+				{
+					if (!Emitted[AdjacentTriangles[i]])
+					{
+						Candidates.Add(AdjacentTriangles[i]);
+					}
+				}
+			}
+			MeshletTriangles.Add((uint8)Slots[Vertex]);
+			--LiveTriangles[Vertex];
+		}
+		Emitted[Best] = true;
+		++NumEmitted;
+
+		if ((uint32)MeshletTriangles.Num() == Settings.MaxTriangles * 3)
+		{
+			Flush();
+		}
+	}
+	if (MeshletTriangles.Num() > 0)
+	{
+		Flush();
+	}
+}
+
+void ns_yoyo::BuildStaticMeshMeshlets(FStaticMeshResource& Resource, const FMeshletSettings& Settings)
+{
+	TArray<FSectionJob> Jobs;
+	for (int32 LODIndex = 0; LODIndex < Resource.LODs.Num(); ++LODIndex)
+	{
+		const FStaticMeshLOD& LOD = Resource.LODs[LODIndex];
+		for (int32 SectionIndex = 0; SectionIndex < LOD.Sections.Num(); ++SectionIndex)
+		{
+			const FStaticMeshSection& Section = LOD.Sections[SectionIndex];
+			Jobs.Add({ LODIndex, LOD.VertexBufferIndex, (uint32)SectionIndex, Section.FirstIndex, Section.NumTriangles });
+		}
+	}
+
+	TArray<FMeshletBuffer> LODMeshlets;
+	LODMeshlets.SetNum(Resource.LODs.Num());
+	RunSectionJobs(Jobs, Resource.VertexBuffers, Resource.IndexBuffer.BufferData, Settings, LODMeshlets);
+	for (int32 LODIndex = 0; LODIndex < Resource.LODs.Num(); ++LODIndex)
+	{
+		Resource.LODs[LODIndex].Meshlets = MoveTemp(LODMeshlets[LODIndex]);
+	}
+}
+
+void ns_yoyo::BuildSkeletalMeshMeshlets(FSkeletalMeshResource& Resource, const FMeshletSettings& Settings)
+{
+	TArray<FSectionJob> Jobs;
+	for (int32 LODIndex = 0; LODIndex < Resource.LODs.Num(); ++LODIndex)
+	{
+		const FSkeletalMeshLOD& LOD = Resource.LODs[LODIndex];
+		for (int32 SectionIndex = 0; SectionIndex < LOD.RenderSections.Num(); ++SectionIndex)
+		{
+			const FSkelMeshRenderSection& Section = LOD.RenderSections[SectionIndex];
+			Jobs.Add({ LODIndex, LOD.VertexBufferIndex, (uint32)SectionIndex, Section.BaseIndex, Section.NumTriangles });
+		}
+	}
+
+	TArray<FMeshletBuffer> LODMeshlets;
+	LODMeshlets.SetNum(Resource.LODs.Num());
+	RunSectionJobs(Jobs, Resource.VertexBuffers, Resource.IndexBuffer.BufferData, Settings, LODMeshlets);
+	for (int32 LODIndex = 0; LODIndex < Resource.LODs.Num(); ++LODIndex)
+	{
+		Resource.LODs[LODIndex].Meshlets = MoveTemp(LODMeshlets[LODIndex]);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	struct FMeshletSettings
+	{
+		// at most 256, triangles index the meshlet's vertices with a byte
+		uint32 MaxVertices = 64;
+		uint32 MaxTriangles = 124;
+	};
+
+	/*
+	* Splits a triangle list into meshlets, appended to Out with SectionIndex. A meshlet grows by the
+	* triangle around its vertices adding the fewest new vertices, then the one whose vertices have
+	* the fewest unused triangles left, then the lowest index. A new one starts at the first unused
+	* triangle when none fits. Run it after OptimizeMeshSections so the seeds follow the cache order.
+	* Positions are indexed by the values in Indices, bounds and cones are left empty without them.
+	*/
+	void BuildMeshlets(const uint32* Indices, uint32 NumTriangles, const TArray<FVector>& Positions, uint32 SectionIndex,
+		FMeshletBuffer& Out, const FMeshletSettings& Settings = FMeshletSettings());
+
+	/*
+	* Fills FMeshletBuffer of every LOD. Sections are split side by side with ParallelFor and appended
+	* in LOD and section order, so the result doesn't depend on the thread count.
+	*/
+	void BuildStaticMeshMeshlets(FStaticMeshResource& Resource, const FMeshletSettings& Settings = FMeshletSettings());
+	void BuildSkeletalMeshMeshlets(FSkeletalMeshResource& Resource, const FMeshletSettings& Settings = FMeshletSettings());
+}
@@ -0,0 +1,246 @@
+#include "SceneBVH.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	struct FBuildInstance
+	{
+		ns_yoyo::FAABB Bounds;
+		FVector Center;
+		uint32 Index;
+	};
+
+	struct FBin
+	{
+		ns_yoyo::FAABB Bounds;
+		int32 Count = 0;
+	};
+
+	// relative cost of visiting a node against testing one instance, for the SAH
+	constexpr float TraversalCost = 1.f;
+
+	class FBVHBuilder
+	{
+	public:
+		FBVHBuilder(TArray<FBuildInstance>& InInstances, const ns_yoyo::FSceneBVHSettings& InSettings)
+			: Instances(InInstances)
+			, Settings(InSettings)
+		{
+		}
+
+		// appends the subtree over Instances[First, First + Num) to Nodes, child indices are indices into Nodes
+		void Build(int32 First, int32 Num, TArray<ns_yoyo::FBVHNode>& Nodes) const
+		{
+			using namespace ns_yoyo;
+			FAABB Bounds;
+			FAABB CenterBounds;
+			for (int32 i = First; i < First + Num; ++i)
+			{
+				Bounds += Instances[i].Bounds;
+				CenterBounds += Instances[i].Center;
+			}
+
+			const int32 NodeIndex = Nodes.AddZeroed(1);
+			const int32 NumLeft = Split(First, Num, Bounds, CenterBounds);
+			uint32 RightChild = 0;
+			if (NumLeft == 0)
+			{
+				FBVHNode& Leaf = Nodes[NodeIndex];
+				Leaf.BoundsMin = Bounds.Min;
+				Leaf.BoundsMax = Bounds.Max;
+				Leaf.RightChildOrFirstInstance = First;
+				Leaf.NumInstances = Num;
+				return;
+			}
+
+			if (Num >= Settings.MinParallelInstances)
+			{
+				// both halves on their own task, then concatenated left before right as in the serial build
+				TArray<FBVHNode> Subtrees[2];
+				ParallelFor(2, [this, First, Num, NumLeft, &Subtrees](int32 Child)
+				{
+					if (Child == 0)
+					{
+						Build(First, NumLeft, Subtrees[0]);
+					}
+					else
+					{
+						Build(First + NumLeft, Num - NumLeft, Subtrees[1]);
+					}
+				});
+				AppendSubtree(Subtrees[0], Nodes);
+				RightChild = Nodes.Num();
+				AppendSubtree(Subtrees[1], Nodes);
+			}
+			else
+			{
+				Build(First, NumLeft, Nodes);
+				RightChild = Nodes.Num();
+				Build(First + NumLeft, Num - NumLeft, Nodes);
+			}
+
+			FBVHNode& Inner = Nodes[NodeIndex];
+			Inner.BoundsMin = Bounds.Min;
+			Inner.BoundsMax = Bounds.Max;
+			Inner.RightChildOrFirstInstance = RightChild;
+			Inner.NumInstances = 0;
+		}
+
+	private:
+		int32 GetBin(const FBuildInstance& Instance, int32 Axis, float Min, float Scale) const
+		{
+			return FMath::Clamp((int32)((Instance.Center[Axis] - Min) * Scale), 0, Settings.NumBins - 1);
+		}
+
+		/*
+		* Picks the cheapest binned SAH split over the three axes and partitions the range by it.
+		* Returns the number of instances on the left, 0 when a leaf is cheaper.
+		*/
+		int32 Split(int32 First, int32 Num, const ns_yoyo::FAABB& Bounds, const ns_yoyo::FAABB& CenterBounds) const
+		{
+			using namespace ns_yoyo;
+			if (Num <= 1)
+			{
+				return 0;
+			}
+
+			const int32 NumBins = Settings.NumBins;
+			const FVector CenterExtent = CenterBounds.Max - CenterBounds.Min;
+			float BestCost = MAX_flt;
+			int32 BestAxis = INDEX_NONE;
+			int32 BestBin = 0;
+			TArray<FBin, TInlineAllocator<32>> Bins;
+			TArray<float, TInlineAllocator<32>> RightCosts;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				if (CenterExtent[Axis] <= 0.f)
+				{
+					continue;
+				}
+				const float Scale = NumBins / CenterExtent[Axis];
+				Bins.Reset();
+				Bins.SetNum(NumBins);
+				for (int32 i = First; i < First + Num; ++i)
+				{
+					FBin& Bin = Bins[GetBin(Instances[i], Axis, CenterBounds.Min[Axis], Scale)];
+					Bin.Bounds += Instances[i].Bounds;
+					++Bin.Count;
+				}
+
+				// sweep from the right for the cost of every right side, then from the left
+				RightCosts.SetNumUninitialized(NumBins);
+				FAABB RightBounds;
+				int32 RightCount = 0;
+				for (int32 Bin = NumBins - 1; Bin > 0; --Bin)
+				{
+					RightBounds += Bins[Bin].Bounds;
+					RightCount += Bins[Bin].Count;
+					RightCosts[Bin] = RightCount > 0 ? RightBounds.GetSurfaceArea() * RightCount : MAX_flt;
+				}
+				FAABB LeftBounds;
+				int32 LeftCount = 0;
+				for (int32 Bin = 1; Bin < NumBins; ++Bin)
+				{
+					LeftBounds += Bins[Bin - 1].Bounds;
+					LeftCount += Bins[Bin - 1].Count;
+					if (LeftCount == 0 || RightCosts[Bin] == MAX_flt)
+					{
+						continue;
+					}
+					const float Cost = LeftBounds.GetSurfaceArea() * LeftCount + RightCosts[Bin];
+					if (Cost < BestCost)
+					{
+						BestCost = Cost;
+						BestAxis = Axis;
+						BestBin = Bin;
+					}
+				}
+			}
+
+			if (BestAxis == INDEX_NONE)
+			{
+				// every center in the same spot, only the leaf size forces a split
+				return Num > Settings.MaxLeafInstances ? Num / 2 : 0;
+			}
+			const float Area = Bounds.GetSurfaceArea();
+			if (Num <= Settings.MaxLeafInstances && TraversalCost * Area + BestCost >= Area * Num)
+			{
+				return 0;
+			}
+
+			const float Scale = NumBins / CenterExtent[BestAxis];
+			int32 Left = First;
+			int32 Right = First + Num - 1;
+			while (Left <= Right)
+			{
+				if (GetBin(Instances[Left], BestAxis, CenterBounds.Min[BestAxis], Scale) < BestBin)
+				{
+					++Left;
+				}
+				else
+				{
+					Swap(Instances[Left], Instances[Right]);
+					--Right;
+				}
+			}
+			return Left - First;
+		}
+
+		static void AppendSubtree(const TArray<ns_yoyo::FBVHNode>& Subtree, TArray<ns_yoyo::FBVHNode>& Nodes)
+		{
+			const uint32 Offset = Nodes.Num();
+			Nodes.Reserve(Nodes.Num() + Subtree.Num());
+			for (ns_yoyo::FBVHNode Node : Subtree)
+			{
+				if (!Node.IsLeaf())
+				{
+					Node.RightChildOrFirstInstance += Offset;
+				}
+				Nodes.Add(Node);
+			}
+		}
+
+		TArray<FBuildInstance>& Instances;
+		const ns_yoyo::FSceneBVHSettings& Settings;
+	};
+}
+
+void ns_yoyo::BuildSceneBVH(const TArray<FAABB>& Bounds, FSceneBVH& OutBVH, const FSceneBVHSettings& Settings)
+{
+	OutBVH.Nodes.Reset();
+	OutBVH.InstanceIndices.Reset();
+	if (Bounds.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FBuildInstance> Instances;
+	Instances.SetNumUninitialized(Bounds.Num());
+	for (int32 i = 0; i < Bounds.Num(); ++i)
+	{
+		Instances[i].Bounds = Bounds[i];
+		Instances[i].Center = Bounds[i].GetCenter();
+		Instances[i].Index = i;
+	}
+
+	// a binary tree with at least one instance per leaf has fewer than 2n nodes
+	OutBVH.Nodes.Reserve(Bounds.Num() * 2);
+	FBVHBuilder Builder(Instances, Settings);
+	Builder.Build(0, Instances.Num(), OutBVH.Nodes);
+
+	OutBVH.InstanceIndices.SetNumUninitialized(Instances.Num());
+	for (int32 i = 0; i < Instances.Num(); ++i)
+	{
+		OutBVH.InstanceIndices[i] = Instances[i].Index;
+	}
+}
+
+void ns_yoyo::BuildStaticMeshBVH(FLevelSceneInfo& SceneInfo, const FSceneBVHSettings& Settings)
+{
+	TArray<FAABB> Bounds;
+	for (const FStaticMeshInstanceGroup& Group : SceneInfo.StaticMeshInstanceGroups)
+	{
+		Bounds.Append(Group.Bounds);
+	}
+	BuildSceneBVH(Bounds, SceneInfo.StaticMeshBVH, Settings);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	struct FSceneBVHSettings
+	{
+		// leaves hold at most this many instances, fewer when the SAH finds a cheaper split
+		int32 MaxLeafInstances = 8;
+		// split candidates per axis of the binned SAH
+		int32 NumBins = 16;
+		// subtrees with at least this many instances are built on their own task
+		int32 MinParallelInstances = 4096;
+	};
+
+	/*
+	* Builds a binned SAH BVH over Bounds, OutBVH.InstanceIndices index into Bounds.
+	* Both children of a large node are built side by side with ParallelFor, subtrees are
+	* concatenated in a fixed order so the result doesn't depend on the thread count.
+	*/
+	void BuildSceneBVH(const TArray<FAABB>& Bounds, FSceneBVH& OutBVH, const FSceneBVHSettings& Settings = FSceneBVHSettings());
+
+	// the BVH over every static mesh instance of the scene, numbered across the groups in order
+	void BuildStaticMeshBVH(FLevelSceneInfo& SceneInfo, const FSceneBVHSettings& Settings = FSceneBVHSettings());
+}
@@ -0,0 +1,47 @@
+#include "SceneCells.h"
+
+void ns_yoyo::SplitSceneIntoCells(const FLevelSceneInfo& SceneInfo, float CellSize, TArray<FSceneCellChunk>& OutChunks)
+{
+	check(CellSize > 0.f);
+	OutChunks.Reset();
+	TMap<FIntPoint, int32> ChunkIndices;
+	// per chunk, index of the group of every resource of the index
+	TArray<TMap<int32, int32>> ChunkGroupIndices;
+
+	for (const FStaticMeshInstanceGroup& Group : SceneInfo.StaticMeshInstanceGroups)
+	{
+		for (int32 InstanceIndex = 0; InstanceIndex < Group.GetNumInstances(); ++InstanceIndex)
+		{
+			const FAABB& Bounds = Group.Bounds[InstanceIndex];
+			const FVector Center = Bounds.GetCenter();
+			const FIntPoint Coord(FMath::FloorToInt(Center.X / CellSize), FMath::FloorToInt(Center.Y / CellSize));
+
+			int32* ChunkIndex = ChunkIndices.Find(Coord);
+			if (!ChunkIndex)
+			{
+				FSceneCellChunk& NewChunk = OutChunks.AddDefaulted_GetRef();
+				NewChunk.Cell.Coord = Coord;
+				ChunkGroupIndices.AddDefaulted();
+				ChunkIndex = &ChunkIndices.Add(Coord, OutChunks.Num() - 1);
+			}
+			FSceneCellChunk& Chunk = OutChunks[*ChunkIndex];
+
+			int32* LocalGroupIndex = ChunkGroupIndices[*ChunkIndex].Find(Group.ResourceIndex);
+			if (!LocalGroupIndex)
+			{
+				FStaticMeshInstanceGroup& NewGroup = Chunk.SceneInfo.StaticMeshInstanceGroups.AddDefaulted_GetRef();
+				NewGroup.ResourceIndex = Chunk.SceneInfo.StaticMeshResourcePaths.Add(SceneInfo.StaticMeshResourcePaths[Group.ResourceIndex]);
+				Chunk.Cell.ResourceIndices.Add(Group.ResourceIndex);
+				LocalGroupIndex = &ChunkGroupIndices[*ChunkIndex].Add(Group.ResourceIndex, Chunk.SceneInfo.StaticMeshInstanceGroups.Num() - 1);
+			}
+			Chunk.SceneInfo.StaticMeshInstanceGroups[*LocalGroupIndex].CopyInstance(Group, InstanceIndex);
+			Chunk.Cell.Bounds += Bounds;
+			++Chunk.Cell.NumInstances;
+		}
+	}
+
+	OutChunks.Sort([](const FSceneCellChunk& A, const FSceneCellChunk& B)
+	{
+		return A.Cell.Coord.Y != B.Cell.Coord.Y ? A.Cell.Coord.Y < B.Cell.Coord.Y : A.Cell.Coord.X < B.Cell.Coord.X;
+	});
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	// a scene chunk and its entry in the index scene
+	struct FSceneCellChunk
+	{
+		// Path is left for the caller to fill
+		FSceneCell Cell;
+		// the instances of the cell, resource indices refer to the chunk's own path table
+		FLevelSceneInfo SceneInfo;
+	};
+
+	/*
+	* Splits the static mesh instances of SceneInfo into square cells of CellSize on the XY plane,
+	* each instance goes to the cell holding the center of its bounds. Cells are sorted by Y then X,
+	* instances keep their group order within a cell.
+	*/
+	void SplitSceneIntoCells(const FLevelSceneInfo& SceneInfo, float CellSize, TArray<FSceneCellChunk>& OutChunks);
+}
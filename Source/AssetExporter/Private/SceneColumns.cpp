@@ -0,0 +1,83 @@
+#include "SceneColumns.h"
+
+namespace
+{
+	void AddInstance(ns_yoyo::FSceneInstanceColumns& Columns, ns_yoyo::ESceneEncoding Encoding, uint32 ResourceIndex,
+		const FQuat& Rotation, const FVector& Translation, const FVector& Scale)
+	{
+		Columns.ResourceIndices.Add(ResourceIndex);
+		if (Encoding == ns_yoyo::ESceneEncoding::Matrices)
+		{
+			Columns.Matrices.Add(ns_yoyo::GetMatrix3x4(Rotation, Translation, Scale));
+		}
+		else
+		{
+			Columns.Rotations.Add(Rotation);
+			Columns.Translations.Add(FVector4(Translation, 0.f));
+			Columns.Scales.Add(FVector4(Scale, 0.f));
+		}
+	}
+
+	void ReserveInstances(ns_yoyo::FSceneInstanceColumns& Columns, ns_yoyo::ESceneEncoding Encoding, int32 NumInstances)
+	{
+		Columns.ResourceIndices.Reserve(NumInstances);
+		if (Encoding == ns_yoyo::ESceneEncoding::Matrices)
+		{
+			Columns.Matrices.Reserve(NumInstances);
+		}
+		else
+		{
+			Columns.Rotations.Reserve(NumInstances);
+			Columns.Translations.Reserve(NumInstances);
+			Columns.Scales.Reserve(NumInstances);
+		}
+	}
+}
+
+ns_yoyo::FMatrix3x4 ns_yoyo::GetMatrix3x4(const FQuat& Rotation, const FVector& Translation, const FVector& Scale)
+{
+	return FMatrix3x4::FromMatrix(FTransform(Rotation, Translation, Scale).ToMatrixWithScale());
+}
+
+void ns_yoyo::EncodeSceneColumns(FLevelSceneInfo& SceneInfo, ESceneEncoding Encoding)
+{
+	if (Encoding == ESceneEncoding::Records || SceneInfo.Encoding != ESceneEncoding::Records)
+	{
+		return;
+	}
+	SceneInfo.Encoding = Encoding;
+
+	int32 NumStaticInstances = 0;
+	for (const FStaticMeshInstanceGroup& Group : SceneInfo.StaticMeshInstanceGroups)
+	{
+		NumStaticInstances += Group.GetNumInstances();
+	}
+	FSceneInstanceColumns& StaticInstances = SceneInfo.StaticMeshInstances;
+	ReserveInstances(StaticInstances, Encoding, NumStaticInstances);
+	StaticInstances.Bounds.Reserve(NumStaticInstances);
+	for (const FStaticMeshInstanceGroup& Group : SceneInfo.StaticMeshInstanceGroups)
+	{
+		for (int32 InstanceIndex = 0; InstanceIndex < Group.GetNumInstances(); ++InstanceIndex)
+		{
+			AddInstance(StaticInstances, Encoding, Group.ResourceIndex, Group.Rotations[InstanceIndex],
+				Group.Translations[InstanceIndex], Group.Scales[InstanceIndex]);
+		}
+		StaticInstances.Bounds.Append(Group.Bounds);
+	}
+	SceneInfo.StaticMeshInstanceGroups.Empty();
+
+	// one path per skeletal mesh, however many times it is placed
+	TMap<FString, uint32> SkelMeshResourceIndices;
+	FSceneInstanceColumns& SkelInstances = SceneInfo.SkelMeshInstances;
+	ReserveInstances(SkelInstances, Encoding, SceneInfo.SkelMeshSceneInfos.Num());
+	for (const FSkeletalMeshSceneInfo& Info : SceneInfo.SkelMeshSceneInfos)
+	{
+		uint32* ResourceIndex = SkelMeshResourceIndices.Find(Info.ResourcePath);
+		if (!ResourceIndex)
+		{
+			ResourceIndex = &SkelMeshResourceIndices.Add(Info.ResourcePath, SceneInfo.SkelMeshResourcePaths.Add(Info.ResourcePath));
+		}
+		AddInstance(SkelInstances, Encoding, *ResourceIndex, Info.Transform.Rot, Info.Transform.Trans, Info.Transform.Scale);
+	}
+	SceneInfo.SkelMeshSceneInfos.Empty();
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	// the 3x4 world matrix of a rotation, translation and scale, scaled first
+	FMatrix3x4 GetMatrix3x4(const FQuat& Rotation, const FVector& Translation, const FVector& Scale);
+
+	/*
+	* Moves the instance groups and skeletal mesh records of SceneInfo into FSceneInstanceColumns of
+	* Encoding, interning the skeletal mesh paths. Run it last, after the BVH and the cell split which
+	* read the groups. Records leaves SceneInfo as it is.
+	*/
+	void EncodeSceneColumns(FLevelSceneInfo& SceneInfo, ESceneEncoding Encoding);
+}
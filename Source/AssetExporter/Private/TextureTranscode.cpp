@@ -0,0 +1,83 @@
+#include "TextureTranscode.h"
+#include "Async/ParallelFor.h"
+
+ns_yoyo::ETextureFormat ns_yoyo::GetTextureFormat(EPixelFormat PixelFormat)
+{
+	switch (PixelFormat)
+	{
+	case PF_B8G8R8A8:
+	case PF_R8G8B8A8:
+		return ETextureFormat::RGBA8;
+	case PF_G8:
+		return ETextureFormat::R8;
+	case PF_DXT1:
+		return ETextureFormat::BC1;
+	case PF_DXT5:
+		return ETextureFormat::BC3;
+	case PF_BC4:
+		return ETextureFormat::BC4;
+	case PF_BC5:
+		return ETextureFormat::BC5;
+	case PF_BC6H:
+		return ETextureFormat::BC6H;
+	case PF_BC7:
+		return ETextureFormat::BC7;
+	case PF_FloatRGBA:
+		return ETextureFormat::RGBA16F;
+	default:
+		return ETextureFormat::Max;
+	}
+}
+
+uint64 ns_yoyo::GetMipSize(ETextureFormat Format, int32 SizeX, int32 SizeY)
+{
+	const uint64 NumBlocks = (uint64)FMath::DivideAndRoundUp(SizeX, 4) * FMath::DivideAndRoundUp(SizeY, 4);
+	const uint64 NumTexels = (uint64)SizeX * SizeY;
+	switch (Format)
+	{
+	case ETextureFormat::RGBA8: return NumTexels * 4;
+	case ETextureFormat::R8: return NumTexels;
+	case ETextureFormat::BC1:
+	case ETextureFormat::BC4:
+		return NumBlocks * 8;
+	case ETextureFormat::BC3:
+	case ETextureFormat::BC5:
+	case ETextureFormat::BC6H:
+	case ETextureFormat::BC7:
+		return NumBlocks * 16;
+	case ETextureFormat::RGBA16F: return NumTexels * 8;
+	case ETextureFormat::Max:
+	default:
+		check(false);
+		return 0;
+	}
+}
+
+void ns_yoyo::TranscodeMips(FTextureResource& Texture, EPixelFormat PixelFormat, int32 SizeX, int32 SizeY, const TArray<const void*>& MipData)
+{
+	check(Texture.Format == GetTextureFormat(PixelFormat));
+	Texture.Mips.SetNum(MipData.Num());
+	ParallelFor(MipData.Num(), [&Texture, &MipData, PixelFormat, SizeX, SizeY](int32 MipIndex)
+	{
+		FTextureMip& Mip = Texture.Mips[MipIndex];
+		Mip.SizeX = FMath::Max(SizeX >> MipIndex, 1);
+		Mip.SizeY = FMath::Max(SizeY >> MipIndex, 1);
+		Mip.Data.SetNumUninitialized(GetMipSize(Texture.Format, Mip.SizeX, Mip.SizeY));
+		if (PixelFormat == PF_B8G8R8A8)
+		{
+			const uint32* Src = static_cast<const uint32*>(MipData[MipIndex]);
+			uint32* Dest = reinterpret_cast<uint32*>(Mip.Data.GetData());
+			const int32 NumTexels = Mip.SizeX * Mip.SizeY;
+			for (int32 i = 0; i < NumTexels; ++i)
+			{
+				// bgra to rgba, the bytes of a texel read as a little endian uint32
+				const uint32 Texel = Src[i];
+				Dest[i] = (Texel & 0xFF00FF00) | ((Texel >> 16) & 0xFF) | ((Texel & 0xFF) << 16);
+			}
+		}
+		else
+		{
+			FMemory::Memcpy(Mip.Data.GetData(), MipData[MipIndex], Mip.Data.Num());
+		}
+	});
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	// the format a UE pixel format is exported in, ETextureFormat::Max when there is none
+	ETextureFormat GetTextureFormat(EPixelFormat PixelFormat);
+
+	// bytes of a SizeX x SizeY mip, whole blocks for the block compressed formats
+	uint64 GetMipSize(ETextureFormat Format, int32 SizeX, int32 SizeY);
+
+	/*
+	* Fills the mips of Texture, whose Format must be set, from the platform data mips in MipData,
+	* each half the size of the one before. B8G8R8A8 texels are swizzled into RGBA8, every other
+	* format is copied as it is. Mips are transcoded side by side with ParallelFor.
+	*/
+	void TranscodeMips(FTextureResource& Texture, EPixelFormat PixelFormat, int32 SizeX, int32 SizeY, const TArray<const void*>& MipData);
+}
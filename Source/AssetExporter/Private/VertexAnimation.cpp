@@ -0,0 +1,158 @@
+#include "VertexAnimation.h"
+#include "Async/ParallelFor.h"
+#include "Math/Float16.h"
+
+namespace
+{
+	// the influences of every vertex, resolved to skeleton bones with weights summing to 1
+	struct FVertexInfluences
+	{
+		uint32 NumInfluences = 0;
+		// NumVertices * NumInfluences
+		TArray<int32> Bones;
+		TArray<float> Weights;
+	};
+
+	bool GatherInfluences(FVertexInfluences& Influences, const ns_yoyo::FSkinWeightBuffer& SkinWeights,
+		const ns_yoyo::FSkeletalMeshLOD& LOD, int32 NumBones)
+	{
+		const uint32 NumInfluences = SkinWeights.NumInfluences;
+		const uint32 Stride = SkinWeights.GetStride();
+		Influences.NumInfluences = NumInfluences;
+		Influences.Bones.SetNumZeroed(SkinWeights.NumVertices * NumInfluences);
+		Influences.Weights.SetNumZeroed(SkinWeights.NumVertices * NumInfluences);
+		for (const ns_yoyo::FSkelMeshRenderSection& Section : LOD.RenderSections)
+		{
+			for (uint32 Vertex = Section.BaseVertexIndex; Vertex < Section.BaseVertexIndex + Section.NumVertices; ++Vertex)
+			{
+				const uint8* Src = SkinWeights.RawData.GetData() + Vertex * Stride;
+				const uint8* SrcWeights = Src + NumInfluences * SkinWeights.BoneIndexSize;
+				int32* Bones = Influences.Bones.GetData() + Vertex * NumInfluences;
+				float* Weights = Influences.Weights.GetData() + Vertex * NumInfluences;
+				uint32 WeightSum = 0;
+				for (uint32 i = 0; i < NumInfluences; ++i)
+				{
+					uint16 BoneMapIndex = Src[i];
+					if (SkinWeights.BoneIndexSize == sizeof(uint16))
+					{
+						FMemory::Memcpy(&BoneMapIndex, Src + i * sizeof(uint16), sizeof(uint16));
+					}
+					if (SrcWeights[i] == 0)
+					{
+						continue;
+					}
+					if (!Section.BoneMap.IsValidIndex(BoneMapIndex) || (int32)Section.BoneMap[BoneMapIndex] >= NumBones)
+					{
+						return false;
+					}
+					Bones[i] = Section.BoneMap[BoneMapIndex];
+					WeightSum += SrcWeights[i];
+				}
+				for (uint32 i = 0; i < NumInfluences; ++i)
+				{
+					Weights[i] = WeightSum > 0 ? SrcWeights[i] / (float)WeightSum : 0.f;
+				}
+			}
+		}
+		return true;
+	}
+
+	void StoreHalf4(uint16* Dest, const FVector& Value)
+	{
+		Dest[0] = FFloat16(Value.X).Encoded;
+		Dest[1] = FFloat16(Value.Y).Encoded;
+		Dest[2] = FFloat16(Value.Z).Encoded;
+		Dest[3] = 0;
+	}
+}
+
+bool ns_yoyo::BakeVertexAnimation(FVertexAnimationResource& VertexAnimation, const FSkeletalMeshResource& Mesh, int32 LODIndex,
+	const FAnimSequenceResource& AnimSeq)
+{
+	check(Mesh.LODs.IsValidIndex(LODIndex));
+	check(AnimSeq.BakedSpace == FAnimSequenceResource::EBakedSpace::Skinning);
+	const FSkeletalMeshLOD& LOD = Mesh.LODs[LODIndex];
+	const FVertexBuffer& VertexBuffer = Mesh.VertexBuffers[LOD.VertexBufferIndex];
+	const FSkinWeightBuffer& SkinWeights = Mesh.SkinWeightBuffers[LOD.VertexBufferIndex];
+	check(SkinWeights.NumVertices == VertexBuffer.NumVertices);
+
+	TArray<FVector> Positions;
+	TArray<FVector> Normals;
+	FVertexInfluences Influences;
+	if (!VertexBuffer.GetPositions(Positions) || !VertexBuffer.GetNormals(Normals)
+		|| !GatherInfluences(Influences, SkinWeights, LOD, AnimSeq.NumBakedBones))
+	{
+		return false;
+	}
+
+	const uint32 NumVertices = VertexBuffer.NumVertices;
+	const int32 NumFrames = FMath::Max(AnimSeq.NumFrames, 1);
+	const int32 NumBones = AnimSeq.NumBakedBones;
+	const uint32 NumInfluences = Influences.NumInfluences;
+	VertexAnimation.LODIndex = LODIndex;
+	VertexAnimation.NumVertices = NumVertices;
+	VertexAnimation.NumFrames = NumFrames;
+	VertexAnimation.FrameRate = AnimSeq.FrameRate;
+	VertexAnimation.FrameBounds.SetNum(NumFrames);
+	VertexAnimation.PositionDeltas.SetNumUninitialized(NumFrames * NumVertices * 4);
+	VertexAnimation.NormalDeltas.SetNumUninitialized(NumFrames * NumVertices * 4);
+
+	ParallelFor(NumFrames, [&VertexAnimation, &AnimSeq, &Positions, &Normals, &Influences, NumVertices, NumBones, NumInfluences](int32 Frame)
+	{
+		const FMatrix3x4* Matrices = AnimSeq.BakedMatrices.GetData() + Frame * NumBones;
+		uint16* PositionDeltas = VertexAnimation.PositionDeltas.GetData() + Frame * NumVertices * 4;
+		uint16* NormalDeltas = VertexAnimation.NormalDeltas.GetData() + Frame * NumVertices * 4;
+		VectorRegister BoundsMin = VectorSetFloat1(MAX_flt);
+		VectorRegister BoundsMax = VectorSetFloat1(-MAX_flt);
+		for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			// blend the rows of the influencing matrices
+			const int32* Bones = Influences.Bones.GetData() + Vertex * NumInfluences;
+			const float* Weights = Influences.Weights.GetData() + Vertex * NumInfluences;
+			VectorRegister Row0 = VectorZero();
+			VectorRegister Row1 = VectorZero();
+			VectorRegister Row2 = VectorZero();
+			for (uint32 i = 0; i < NumInfluences; ++i)
+			{
+				if (Weights[i] == 0.f)
+				{
+					continue;
+				}
+				const FMatrix3x4& Matrix = Matrices[Bones[i]];
+				const VectorRegister Weight = VectorSetFloat1(Weights[i]);
+				Row0 = VectorMultiplyAdd(VectorLoad(Matrix.M[0]), Weight, Row0);
+				Row1 = VectorMultiplyAdd(VectorLoad(Matrix.M[1]), Weight, Row1);
+				Row2 = VectorMultiplyAdd(VectorLoad(Matrix.M[2]), Weight, Row2);
+			}
+
+			// (x, y, z, 1) for positions, (x, y, z, 0) for normals
+			const VectorRegister Position = VectorLoadFloat3_W1(&Positions[Vertex]);
+			const VectorRegister Normal = VectorLoadFloat3_W0(&Normals[Vertex]);
+			const VectorRegister PositionXY = VectorShuffle(VectorDot4(Row0, Position), VectorDot4(Row1, Position), 0, 0, 0, 0);
+			const VectorRegister SkinnedPosition = VectorShuffle(PositionXY, VectorDot4(Row2, Position), 0, 2, 0, 0);
+			const VectorRegister NormalXY = VectorShuffle(VectorDot4(Row0, Normal), VectorDot4(Row1, Normal), 0, 0, 0, 0);
+			const VectorRegister SkinnedNormal = VectorShuffle(NormalXY, VectorDot4(Row2, Normal), 0, 2, 0, 0);
+			BoundsMin = VectorMin(BoundsMin, SkinnedPosition);
+			BoundsMax = VectorMax(BoundsMax, SkinnedPosition);
+
+			FVector4 PositionDelta;
+			FVector4 NormalDelta;
+			VectorStoreAligned(VectorSubtract(SkinnedPosition, Position), &PositionDelta);
+			VectorStoreAligned(SkinnedNormal, &NormalDelta);
+			StoreHalf4(PositionDeltas + Vertex * 4, FVector(PositionDelta));
+			StoreHalf4(NormalDeltas + Vertex * 4, FVector(NormalDelta).GetSafeNormal() - Normals[Vertex]);
+		}
+		FVector4 Min;
+		FVector4 Max;
+		VectorStoreAligned(BoundsMin, &Min);
+		VectorStoreAligned(BoundsMax, &Max);
+		VertexAnimation.FrameBounds[Frame] = NumVertices > 0 ? FAABB(FVector(Min), FVector(Max)) : FAABB();
+	});
+
+	VertexAnimation.Bounds = FAABB();
+	for (const FAABB& FrameBounds : VertexAnimation.FrameBounds)
+	{
+		VertexAnimation.Bounds += FrameBounds;
+	}
+	return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ExportTypes.h"
+
+namespace ns_yoyo
+{
+	/*
+	* Skins the vertices of LOD LODIndex of Mesh with the skinning matrices baked into AnimSeq at
+	* every frame and fills the deltas and bounds of VertexAnimation. AnimSeq must be baked in
+	* EBakedSpace::Skinning against the reference skeleton of the mesh, whose bones the sections'
+	* BoneMap index. Frames are skinned side by side with ParallelFor.
+	* Returns false when the LOD has no position or normal to skin.
+	*/
+	bool BakeVertexAnimation(FVertexAnimationResource& VertexAnimation, const FSkeletalMeshResource& Mesh, int32 LODIndex,
+		const FAnimSequenceResource& AnimSeq);
+}
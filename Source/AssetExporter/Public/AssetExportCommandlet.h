@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "AssetExportCommandlet.generated.h"
+
+/*
+*	Exports whole content directories without an editor session, for build machines:
+*
+*	UE4Editor-Cmd <Project> -run=AssetExport -nullrhi -out=<Dir>
+*		[-path=/Game/A,/Game/B]	content paths to export, recursive, /Game by default
+*		[-classes=StaticMesh,SkeletalMesh,AnimSequence,Skeleton,World]	asset classes to export, all but World by default
+*		[-shard=i/N]	export only the i-th of N shards, shards can run side by side into the same output
+*		[-batchsize=64]	assets loaded at a time, garbage is collected between batches
+*/
+UCLASS()
+class ASSETEXPORTER_API UAssetExportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAssetExportCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
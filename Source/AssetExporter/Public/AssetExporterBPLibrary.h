@@ -29,10 +29,13 @@ class ADirectionalLight;
 class USkeletalMesh;
 class UAnimSequence;
 class USkeleton;
+class UTexture2D;
 
 namespace ns_yoyo
 {
 	struct FLevelSceneInfo;
+	class FExportReport;
+	class FExportSession;
 }
 
 UCLASS()
@@ -54,6 +57,34 @@ class ASSETEXPORTER_API UAssetExporterBPLibrary : public UBlueprintFunctionLibra
 
 	static void ExportMap(UWorld* World, const FString& Path);
 
+	// exports into an open session, saving and sweeping its manifest is left to the caller
+	static void ExportMap(UWorld* World, ns_yoyo::FExportSession& Session);
+
+	/*
+	* Exports a batch of loaded assets of any supported type, building them in parallel.
+	* The skeletons of meshes and animations, and the textures of the meshes' materials, are exported
+	* with them, once per session.
+	*/
+	static void ExportAssets(const TArray<UObject*>& Assets, ns_yoyo::FExportSession& Session);
+
+	/*
+	* Every export into Path until EndExportSession shares one session: a dependency or an asset
+	* requested again is written once, and EndExportSession sweeps and saves the manifest.
+	* Exports into any other path keep a session of their own.
+	*/
+	UFUNCTION(BlueprintCallable)
+	static void BeginExportSession(const FString& Path);
+
+	UFUNCTION(BlueprintCallable)
+	static void EndExportSession();
+
+	// AssetExporter.Report, runs keep an FExportReport and save it next to their manifest
+	static bool IsExportReportEnabled();
+	static void SaveExportReport(const ns_yoyo::FExportReport& Report, const FString& BasePath);
+
+	// hash of the export settings that change the exported bytes, see FExportManifest
+	static uint32 GetExportSettingsHash();
+
 	static void ExportCamera(ACameraActor* Camera,
 		ns_yoyo::FLevelSceneInfo& LevelSceneInfo);
 
@@ -65,4 +96,13 @@ class ASSETEXPORTER_API UAssetExporterBPLibrary : public UBlueprintFunctionLibra
 	static void ExportAnimSequence(UAnimSequence* AnimSequence, const FString& Path);
 
 	static void ExportSkeleton(USkeleton* Skeleton, const FString& Path);
+
+	static void ExportTexture(UTexture2D* Texture, const FString& Path);
+
+	/*
+	* Skins SkelMesh offline with every animation into <Mesh>/<Anim>.vat, see FVertexAnimationResource,
+	* and exports the mesh and its skeleton with them. AssetExporter.VertexAnimationLOD picks the LOD.
+	*/
+	UFUNCTION(BlueprintCallable)
+	static void ExportVertexAnimations(USkeletalMesh* SkelMesh, const TArray<UAnimSequence*>& AnimSequences, const FString& Path);
 };